@@ -4,7 +4,7 @@
  * app_config.h
  *
  * Tek noktadan konfig.
- * - Modbus HR map (32 HR)
+ * - Modbus HR map (32 HR) + coil/DI/IR/genis HR region'lari
  * - Watchdog / log ayarlari
  * - P10 HUB12 pin ve tarama ayarlari
  *
@@ -21,21 +21,141 @@
 
 #define APP_MODBUS_HR_COUNT 32u
 
-/* HR address map (Holding Registers)
- *  HR0  : MMM (minutes)
- *  HR1  : SS  (seconds)
- *  HR2  : YYYY
- *  HR3  : MM
- *  HR4  : DD
- *  HR5  : LOG_ENABLE (0/1)
- *  HR6..HR31: reserved / payload
- */
-#define APP_HR_MINUTES    0u
-#define APP_HR_SECONDS    1u
-#define APP_HR_YEAR       2u
-#define APP_HR_MONTH      3u
-#define APP_HR_DAY        4u
-#define APP_HR_LOG_ENABLE 5u
+/* HR address map (Holding Registers), tek kaynak.
+ * X(name, addr, type, min, max, access, hook, ret)
+ *  type  : U16, I16 (tek word) / U32, I32, F32 (2 word) / U64, I64, F64 (4 word)
+ *          Cok word'lu degerler Modbus ile sadece butun olarak yazilabilir (yarim yazma -> 0x02).
+ *  min/max: clamp araligi (tek word tipler). F32 icin tamsayi muhendislik sinirlari.
+ *  access: RW, RO (RO: Modbus ile yazilamaz -> exception 0x02)
+ *  hook  : NONE, TIME (MMM/SS degisimi -> P10 + log)
+ *  ret   : VOL, RET (RET: reset/enerji kesintisinden sonra geri yuklenir, APP_RETAIN_*)
+ * Listelenmeyen adresler: U16, 0..65535, RW, hook yok, VOL (HR6..HR31: reserved / payload).
+ * Bu tablodan: APP_HR_<name> adresleri, clamp/erisim/hook tablolari ve
+ * LOG klasorundeki REGMAP.CSV (SCADA import) uretilir. */
+#define APP_HR_TABLE(X) \
+  X(MINUTES,    0, U16, 0, 999,   RW, TIME, VOL) \
+  X(SECONDS,    1, U16, 0, 59,    RW, TIME, VOL) \
+  X(YEAR,       2, U16, 0, 65535, RW, NONE, RET) \
+  X(MONTH,      3, U16, 0, 65535, RW, NONE, RET) \
+  X(DAY,        4, U16, 0, 65535, RW, NONE, RET) \
+  X(LOG_ENABLE, 5, U16, 0, 65535, RW, NONE, RET)
+
+#define APP_HR_ADDR_(name, addr, type, mn, mx, acc, hook, ret) APP_HR_##name = (addr),
+enum { APP_HR_TABLE(APP_HR_ADDR_) };
+
+/* Register map: her unit icin 4 Modbus tablosu (coil, DI, IR, HR) region tablosu ile.
+ * Adres -> region O(1): 2^APP_REGS_PAGE_SHIFT adreslik her sayfada en fazla bir region
+ * (region'lar sayfa sinirinda baslamak zorunda degil, sadece ayni sayfayi paylasamaz). */
+#define APP_REGS_MAX_REGIONS 5u /* ana HR: HR0..31, ext, TXN_CTRL, diag + 1 bos */
+#define APP_REGS_PAGE_SHIFT  8u
+
+/* 32/64-bit register word sirasi (map basina; APP_RegsMapInit varsayilani)
+ *  0 = BE (ABCD, yuksek word once; S7 MB_SERVER), 1 = WS (CDAB, word swap), 2 = LE (DCBA) */
+#define APP_REGS_WORD_ORDER  0u
+
+/* Transaction group (ana bank HR0..31): TXN_CTRL'e 1 = BEGIN, 2 = COMMIT, 0 = ABORT.
+ * TXN_CTRL eski HR0..31 penceresinin disinda, kendi sayfasinda tek word'luk region:
+ * HR0..31'e blok yazan (FC16/FC23) istemciler ona dokunmaz. REGMAP.CSV'de de listelenir.
+ * BEGIN..COMMIT arasi yazmalar shadow'da bekler, COMMIT'te hepsi birden gorunur.
+ * Transaction BEGIN'i yazan baglantiya aittir: acikken diger istemcilerin yazmalari
+ * exception 0x06 (busy) alir. Baglanti kapaninca ya da bu sure dolunca iptal edilir
+ * (supervisor 250 ms'de bir kontrol eder). */
+#define APP_REGS_TXN_ENABLE     1
+#define APP_REGS_TXN_CTRL_ADDR  3840u /* 0x0F00, diag blogunun (0x1000) hemen alti */
+#define APP_REGS_TXN_TIMEOUT_MS 2000u
+
+/* Retentive HR'ler (ret = RET): degisince hemen backup SRAM'e (4 KB, VBAT ile korunur)
+ * yansitilir; ilk degisiklikten APP_RETAIN_FLASH_DELAY_MS sonra toplu olarak flash'a
+ * (log-structured, iki sektor ping-pong) yazilir. Boot'ta once backup SRAM, gecersizse flash.
+ * Flash sektorleri linker script'te (STM32F407VETX_FLASH.ld, FLASH_RET) ayrilmistir.
+ * Not: F407 tek bank; program/erase sirasinda flash'tan calisan kod (ISR'ler dahil) bekler.
+ * BSY beklemesi RAM'de (app_retain_flash.c), stall'in siniri:
+ *  - word program (flush'ta record basina): typ 16 us, max 100 us (DS8626, x32)
+ *  - 16 KB sektor silme (sadece compaction): typ 250 ms, APP_RETAIN_FLASH_ERASE_MAX_MS
+ *  - compaction en fazla (sektor word'u - 2 - N) / N flush'ta bir (N: RET register sayisi);
+ *    4 RET ile her flush hepsini degistirse bile ~1000 flush * DELAY_MS = ~34 dk'da bir.
+ *  - omur (sektor basina 10k silme): bu en kotu durum surekli olursa ~1.3 yil; RET'ler
+ *    (tarih, log enable) gunde birkac kez degistiginde pratikte sinirsiz (Tests/test_retain).
+ * Bu sure boyunca Modbus/TIM7/SysTick de durur (ETH DMA RX descriptor'lari dolabilir,
+ * TCP retransmit ile toparlar). Olculen en kotu sure: app_retain_stats_t.erase_max_us. */
+#define APP_RETAIN_ENABLE          1
+#define APP_RETAIN_FLASH_ENABLE    1
+#define APP_RETAIN_FLASH_DELAY_MS  2000u
+#define APP_RETAIN_FLASH_SECTOR_A  FLASH_SECTOR_1   /* 0x08004000, 16 KB */
+#define APP_RETAIN_FLASH_ADDR_A    0x08004000u
+#define APP_RETAIN_FLASH_SECTOR_B  FLASH_SECTOR_2   /* 0x08008000, 16 KB */
+#define APP_RETAIN_FLASH_ADDR_B    0x08008000u
+#define APP_RETAIN_FLASH_SIZE      0x4000u
+#define APP_RETAIN_FLASH_ERASE_MAX_MS 500u /* datasheet max, watchdog'a karsi kontrol */
+
+/* Register degisiklik bildirimi: en fazla subscriber (P10, log, network push, ...) */
+#define APP_REGS_MAX_SUBS 4u
+
+/* Ana unit ek alanlari (COUNT = 0: map'e eklenmez). HR0..31 yukaridaki sabit map. */
+#define APP_REGS_HR_EXT_BASE   1000u
+#define APP_REGS_HR_EXT_COUNT  2000u
+#define APP_REGS_IR_BASE       0u
+#define APP_REGS_IR_COUNT      256u
+#define APP_REGS_COIL_BASE     0u
+#define APP_REGS_COIL_COUNT    512u
+#define APP_REGS_DI_BASE       0u
+#define APP_REGS_DI_COUNT      256u
+
+/* Unit ID routing: her UID kendi register bankina gider; bilinmeyen UID -> exception 0x0B.
+ * Ana bank APP_MODBUS_UNIT_ID (10) uzerinde. Zone unit'leri UID BASE..BASE+COUNT-1. */
+#define APP_MODBUS_MAX_UNITS        8u
+#define APP_MODBUS_ZONE_UNIT_COUNT  0u
+#define APP_MODBUS_ZONE_UNIT_BASE   11u
+#define APP_MODBUS_ZONE_HR_COUNT    32u
+
+/* Function code dispatch tablosu kapasitesi */
+#define APP_MODBUS_FC_TABLE_SIZE 16u
+
+/* Diagnostics block: FC03 ile HR[0x1000..] (read-only, per-FC sayac + DWT cycle) */
+#define APP_MODBUS_DIAG_HR_BASE  0x1000u
+#define APP_MODBUS_DIAG_HR_COUNT (12u + 12u * APP_MODBUS_FC_TABLE_SIZE)
+
+/* FC03/FC04 cevap cache'i: en sik okunan (unit, adres, adet) pencereleri.
+ * Bank generation degismediyse serilestirilmis cevap aynen gonderilir. 0 = kapali */
+#define APP_MODBUS_RESP_CACHE_SLOTS 4u
+
+/* Register yazma gecmisi: CCMRAM ring (12 byte/kayit, warm reset'te korunur), FC20 Read File Record ile okunur
+ * (file 0 = header, file 1 = kayitlar; app_hist.h). Kayit sayisi <= 1666 (record no <= 9999) */
+#define APP_HIST_ENABLE 1
+#define APP_HIST_COUNT  1024u
+
+/* Sistem metrikleri: FC04 ile IR[APP_METRICS_IR_BASE..] (read-only, okununca hesaplanir; app_metrics.h) */
+#define APP_METRICS_ENABLE  1
+#define APP_METRICS_IR_BASE 0x1000u
+
+/* Modbus TCP server engine (compile-time secim)
+ * NETCONN: ayri modbus task, netconn API (varsayilan)
+ * RAW    : tcp_recv/tcp_sent/tcp_poll callback'leri, cevap tcpip_thread icinden */
+#define APP_MODBUS_ENGINE_NETCONN 0
+#define APP_MODBUS_ENGINE_RAW     1
+#define APP_MODBUS_ENGINE         APP_MODBUS_ENGINE_NETCONN
+
+/* Ayni anda servis edilen Modbus TCP istemci sayisi (PLC + HMI + historian).
+ * Ust sinir lwipopts.h icindeki MEMP_NUM_NETCONN / MEMP_NUM_TCP_PCB (listener dahil). */
+#define APP_MODBUS_MAX_CONN 4u
+
+/* Bir recv batch'indeki tum cevaplar bu tampona toplanip tek netconn_write ile gider.
+ * Varsayilan = TCP_MSS (536); en az bir max ADU (260) sigmali. */
+#define APP_MODBUS_TX_BATCH_SIZE 536u
+
+/* Send window'u bu sure hic ilerlemeyen (okumayan / olu) istemci kapatilir.
+ * Diger session'lar bu sirada bloklanmaz (nonblocking write + session basina bekleyen TX). */
+#define APP_MODBUS_TX_STALL_MS 5000u
+
+/* Modbus/UDP (port 502, ayni MBAP + PDU engine). Poller sayisi sinirsiz (baglantisiz). */
+#define APP_MODBUS_UDP_ENABLE 1
+
+/* 1: netconn callback + thread flag ile uyan (idle'da CPU harcamaz)
+ * 0: eski osDelay(5) polling dongusu */
+#define APP_MODBUS_EVENT_DRIVEN 1
+
+/* Event modunda olay gelmezse en gec bu kadar sonra uyan (supervisor kick) */
+#define APP_MODBUS_IDLE_WAIT_MS 500u
 
 // ============================================================
 // WATCHDOG
@@ -54,13 +174,62 @@
 /* Queue wait / task pacing */
 #define APP_LOG_SAMPLE_PERIOD_MS 250u
 
-/* fsync period */
-#define APP_LOG_SYNC_PERIOD_MS 1000u
+/* Durability window: bir record'un f_sync'e kadar bekleyebilecegi en uzun sure
+ * (elektrik kesintisinde kaybedilebilecek en fazla log) */
+#define APP_LOG_FLUSH_MAX_AGE_MS 2000u
+
+/* Writer staging buffer boyu (SRAM; SDIO DMA CCMRAM'e erisemez).
+ * 512'nin kati: dolan buffer f_write'a tam sektorler olarak gider (multi-block write) */
+#define APP_LOG_BUF_SIZE 2048u
+
+/* Log task -> writer sample ring'i (CCMRAM, 76 byte/slot, 2'nin kuvveti).
+ * Boyu CCMRAM'e bagli: 64 KB'in 12 KB'i FC20 yazma gecmisi (APP_HIST_COUNT x 12 B),
+ * 512 x 76 B = 38 KB; 1024 slot (76 KB) sigmaz. 1 Hz ROW'da ~8.5 dk, sampler'in
+ * tam yukunde (4 kanal, ~290 kayit/s) ~1.7 s SD takilmasini kayipsiz karsilar
+ * (host olcumu: 250 ms stall'da ring_hwm ~50, Tests/test_log.c) */
+#define APP_LOG_RING_SLOTS 512u
+
+/* Ring doluyken: DROP_NEWEST (yeni kayit), DROP_OLDEST (en eski kayit) ya da
+ * BLOCK (log task APP_LOG_RING_BLOCK_MS bekler, sonra yeni kayit dusurulur).
+ * Kayiplar metrics'te: ring_drops, ring_hwm, drop_last_ms */
+#define APP_LOG_RING_DROP_NEWEST 0
+#define APP_LOG_RING_DROP_OLDEST 1
+#define APP_LOG_RING_BLOCK       2
+#define APP_LOG_RING_POLICY      APP_LOG_RING_DROP_NEWEST
+#define APP_LOG_RING_BLOCK_MS    200u
 
 /* Payload block to append into CSV (HR6..HR15) */
 #define APP_LOG_PAYLOAD_START_HR 6u
 #define APP_LOG_PAYLOAD_COUNT_HR 10u
 
+/* Gunluk dosya on-tahsisi (f_expand, ffconf _USE_EXPAND): dosya tek parca ayrilir,
+ * append'ler diskio ile dogrudan sektorlere; dir entry boyu yalnizca sync'te yazilir.
+ * Bir gunluk log'u karsilamali (BIN 30 B/s ~2.6 MB, CSV ~7 MB). 0: klasik FatFs append */
+#define APP_LOG_PREALLOC_BYTES (8u * 1024u * 1024u)
+
+/* Log dosya formati
+ * CSV: satir basina metin (~60-80 byte)
+ * BIN: sabit boyutlu little-endian record + CRC16, self-describing header (app_log.c);
+ *      PC'de Tools/mblog2csv.py ile CSV'ye cevrilir */
+#define APP_LOG_FORMAT_CSV 0
+#define APP_LOG_FORMAT_BIN 1
+#define APP_LOG_FORMAT     APP_LOG_FORMAT_CSV
+
+/* Periyodik / deadband sampler (app_log.c): kanal basina rate + HR listesi,
+ * logs/YYYYMMDD.SMP'ye binary yazilir. Kanal config'i SD'de APP_LOG_SMP_CFG_FILE
+ * (HR bank'ta yer yok), dosya yoksa sampler pasif. */
+#define APP_LOG_SMP_ENABLE 1
+#define APP_LOG_SMP_CHANNELS 4u
+
+/* Sampler tick'i: TIM7 (APP_P10_SCAN_IRQ_HZ) bolunerek; kanal rate'i bunun bolenine yuvarlanir */
+#define APP_LOG_SMP_TICK_HZ 100u
+
+#define APP_LOG_SMP_CFG_FILE APP_LOG_DIR "/SAMPLER.CSV"
+
+/* SMP gun dosyasi on-tahsisi (APP_LOG_PREALLOC_BYTES 0 ise kullanilmaz).
+ * 100 Hz x 32 register ~6.5 KB/s: bir gun icin ~560 MB; dolunca klasik append */
+#define APP_LOG_SMP_PREALLOC_BYTES (64u * 1024u * 1024u)
+
 // ============================================================
 // P10 HUB12
 // ============================================================
@@ -90,6 +259,9 @@
 /* Tarama ISR frekansi (Hz). 4kHz -> flicker yok, CPU kabul edilebilir. */
 #define APP_P10_SCAN_IRQ_HZ 4000u
 
+/* P10 task register degisiklik bildirimi ile uyanir; olay yoksa en gec bu kadar (supervisor kick) */
+#define APP_P10_IDLE_WAIT_MS 500u
+
 // ---------------- P10 PIN MAP (Black Board P4/P5 Header) ----------------
 // Bu kartta P10 hatlari P4/P5 header uzerinden Port A/B'ye alindi.
 // Baglanti yaparken pin numarasi saymak yerine kart ustu etiketleri (A6/A4/A5/A3/A0, B1/B0) ile git.
@@ -0,0 +1,53 @@
+#ifndef APP_HIST_H
+#define APP_HIST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Register yazma gecmisi (CCMRAM ring, APP_HIST_COUNT kayit). Warm reset'te korunur
+ * (magic/layout dogrulamasi), soguk aciliste temizlenir.
+ * FC20 (Read File Record) ile okunur:
+ *  file 0: header (APP_HIST_HDR_*)
+ *  file 1: kayitlar, record no = slot * APP_HIST_ENTRY_WORDS + word.
+ *          Toplam sayac k. kaydi (0'dan) slot = k % capacity'ye yazar;
+ *          en eski kayit = total - min(total, capacity).
+ * Kayit word'leri: 0..1 t_ms (yuksek word once), 2 adres, 3 deger,
+ *                  4 unit << 8 | kaynak baglanti, 5 tablo << 8 | FC
+ * Sira numarasi < BOOT olan kayitlar onceki boot'tan: t_ms'leri o boot'un saatine gore.
+ */
+
+#define APP_HIST_FILE_HDR    0u
+#define APP_HIST_FILE_DATA   1u
+#define APP_HIST_ENTRY_WORDS 6u
+
+/* header (file 0) word offset'leri */
+enum {
+  APP_HIST_HDR_VERSION = 0,
+  APP_HIST_HDR_ENTRY_WORDS,
+  APP_HIST_HDR_CAPACITY,
+  APP_HIST_HDR_TOTAL_HI,
+  APP_HIST_HDR_TOTAL_LO,
+  APP_HIST_HDR_HEAD,     /* siradaki yazilacak slot */
+  APP_HIST_HDR_NOW_HI,   /* okuma anindaki t_ms */
+  APP_HIST_HDR_NOW_LO,
+  APP_HIST_HDR_BOOT_HI,  /* v2: bu boot'taki ilk kaydin sira numarasi */
+  APP_HIST_HDR_BOOT_LO,
+  APP_HIST_HDR_WORDS
+};
+
+void     APP_HistInit(void);
+/* O(1), allocation yok. Tek Modbus engine context'inden cagrilir (lock yok) */
+void     APP_HistAppend(uint8_t unit, uint8_t table, uint8_t fc, uint8_t src,
+                        uint16_t addr, uint16_t value);
+/* FC20 file/record okumasi. Donus: qty, 0 = gecersiz file / record araligi */
+uint16_t APP_HistReadFile(uint16_t file, uint16_t rec, uint16_t *out, uint16_t qty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_HIST_H */
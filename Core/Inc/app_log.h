@@ -7,9 +7,31 @@
 extern "C" {
 #endif
 
+typedef struct {
+  uint32_t lines;         /* yazilan satir */
+  uint32_t drops;         /* yazilamayan satir (ring dolu / f_write hatasi) */
+  uint32_t write_last_us; /* son SD islemi (f_write / f_sync / gun dosyasi acilisi) suresi */
+  uint32_t write_max_us;
+  uint32_t flushes;       /* SD'ye yazilan staging buffer */
+  uint32_t syncs;         /* f_sync (durability window / gun degisimi / kapanis) */
+  uint32_t ring_drops;    /* ring dolu, APP_LOG_RING_POLICY ile dusen kayit */
+  uint32_t ring_hwm;      /* ring en yuksek doluluk (kayit) */
+  uint32_t ring_depth;    /* anlik doluluk */
+  uint32_t drop_last_ms;  /* son ring kaybinin tick'i (0: hic) */
+  uint32_t smp_late;      /* log task'in kacirdigi sampler tick'i */
+  uint32_t trims;         /* reboot'tan kalan eski gun on-tahsisi birakildi */
+  uint32_t smp_rejects;   /* SAMPLER.CSV'de atlanan ya da eksik uygulanan kanal satiri */
+} app_log_stats_t;
+
 void APP_LogInit(void);
-void APP_LogNotifyTime(uint16_t minutes, uint16_t seconds);
-void APP_LogTask(void *argument);
+void APP_LogTask(void *argument);       /* snapshot alir, sample ring'ine koyar */
+void APP_LogWriterTask(void *argument); /* ring'i formatlayip SD'ye yazar (FatFs sahibi) */
+void APP_LogGetStats(app_log_stats_t *out);
+void APP_LogSamplerTickISR(void);       /* TIM7 ISR'inden: sampler zaman tabani */
+
+/* Gecmis gun dosyasindan offset'ten okuma (tek task'tan). On-tahsisli (contiguous)
+ * dosyada seek O(1). Bugunun acik dosyasi FR_LOCKED -> -1. Donus: okunan byte / -1 */
+int32_t APP_LogReadAt(uint16_t y, uint8_t m, uint8_t d, uint32_t offset, void *buf, uint32_t len);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,47 @@
+#ifndef APP_MBAP_H
+#define APP_MBAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MBAP: TID(2) + PID(2) + LEN(2) + UID(1); LEN = UID + PDU */
+#define APP_MBAP_HDR_LEN 7u
+#define APP_MBAP_MAX_ADU 260u
+
+/* Donus: 1 = ADU islendi, 0 = yer yok (TX dolu); parse bu ADU'dan once durur */
+typedef int (*app_mbap_adu_fn)(void *ctx, const uint8_t *adu, uint16_t len);
+
+/*
+ * TCP stream reassembler.
+ * Segment icindeki tam ADU'lar yerinde (kopyasiz) parse edilir; sadece iki
+ * segment/pbuf arasinda bolunen ADU stash'e kopyalanir.
+ */
+typedef struct {
+  uint16_t have;                       /* stash'teki byte sayisi */
+  uint8_t  stash[APP_MBAP_MAX_ADU];
+
+  uint32_t adu_count;
+  uint32_t copied_bytes;               /* stash'e kopyalanan toplam byte */
+  uint32_t resync_bytes;               /* bozuk header yuzunden atlanan byte */
+} app_mbap_rx_t;
+
+void APP_MbapReset(app_mbap_rx_t *rx);
+
+/* h[0..6] makul bir MBAP header ise toplam ADU uzunlugu, degilse 0 (datagram framing) */
+uint16_t APP_MbapFrameLen(const uint8_t *h);
+
+/* Bir contiguous parca besle (orn. tek pbuf payload'i). Her tam ADU icin fn cagrilir.
+ * Donus: tuketilen byte. len'den kucukse fn 0 dondu (backpressure): kalan byte'lar
+ * (reddedilen ADU dahil) daha sonra ayni sirayla tekrar beslenmeli. */
+size_t APP_MbapFeed(app_mbap_rx_t *rx, const uint8_t *data, size_t len,
+                    app_mbap_adu_fn fn, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_MBAP_H */
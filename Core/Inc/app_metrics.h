@@ -0,0 +1,28 @@
+#ifndef APP_METRICS_H
+#define APP_METRICS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sistem metrikleri: FC04 ile IR[APP_METRICS_IR_BASE + n], read-only.
+ * Her metrik tablodaki getter ile sadece okundugunda hesaplanir.
+ *   +0 : layout version, +1 : blok uzunlugu (word)
+ *   sonrasi: app_metrics.c s_metrics[] sirasi; 32-bit alanlar hi word once.
+ * Alan eklemek / sirasini degistirmek version'i artirir.
+ */
+
+/* Ana map'e IR fn region olarak ekler (APP_RegsInit sonrasi) */
+void     APP_MetricsInit(void);
+uint16_t APP_MetricsRead(uint16_t off, uint16_t *out, uint16_t qty);
+/* Periyodik (supervisor): uptime saniye akumulatoru ve CPU yuku (son periyot) */
+void     APP_MetricsSample(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_METRICS_H */
@@ -3,10 +3,93 @@
 
 #include <stdint.h>
 
+#include "app_regs.h"
+
 #ifndef APP_MODBUS_TCP_PORT
 #define APP_MODBUS_TCP_PORT 502
 #endif
 
+#ifndef APP_MODBUS_UDP_PORT
+#define APP_MODBUS_UDP_PORT 502
+#endif
+
+/* Per-connection counters (session slot bazinda, yeni baglantida sifirlanir) */
+typedef struct {
+  uint8_t  active;
+  uint32_t adu_count;           /* parse edilen ADU */
+  uint32_t resp_count;          /* gonderilen cevap */
+  uint32_t tx_writes;           /* netconn_write (flush) sayisi */
+  uint32_t resp_per_write_x100; /* ortalama cevap / TCP gonderimi * 100 */
+  uint32_t copied_bytes;        /* reassembler stash kopyasi */
+  uint32_t resync_bytes;
+  uint32_t tx_stalls;           /* send window dolu, cevap bekletildi */
+} app_modbus_conn_stats_t;
+
+/* Modbus/UDP counters (tum pollerlar toplam) */
+typedef struct {
+  uint32_t rx_count;   /* gecerli datagram */
+  uint32_t tx_count;   /* gonderilen cevap */
+  uint32_t drop_count; /* bozuk framing / boyut */
+} app_modbus_udp_stats_t;
+
 void APP_ModbusTask(void *argument);
+uint8_t APP_ModbusGetConnStats(uint8_t slot, app_modbus_conn_stats_t *out);
+void    APP_ModbusGetUdpStats(app_modbus_udp_stats_t *out);
+
+/* ------------------ PDU engine (app_modbus_pdu.c) ------------------ */
+
+typedef struct app_modbus_unit app_modbus_unit_t;
+
+/* Handler: req_pdu[0] = FC. Donus: cevap PDU uzunlugu, -1 = cevap yok.
+ * min_len / max_qty kontrolleri dispatch tarafinda yapilmis olarak gelir. */
+typedef int  (*app_modbus_fc_handler_t)(const app_modbus_unit_t *unit,
+                                        const uint8_t *req_pdu, uint16_t req_len,
+                                        uint8_t *resp_pdu, uint16_t resp_cap);
+typedef void (*app_modbus_post_hook_t)(const app_modbus_unit_t *unit);
+
+/* Sanal slave: UID -> register map (coil/DI/IR/HR). Yazma sonrasi isler bank'in
+ * on_write_locked'i / change notification ile yapilir (app_regs.h). */
+struct app_modbus_unit {
+  uint8_t         uid;
+  app_regs_map_t *map;
+};
+
+/* Builtin FC'leri kaydeder, DWT cycle counter'i acar. Engine baslamadan cagrilir. */
+void    APP_ModbusPduInit(void);
+
+/* FC ekle/degistir. max_qty != 0 ise PDU[3..4] (quantity) 1..max_qty kontrol edilir.
+ * 1 = OK, 0 = tablo dolu / gecersiz FC */
+uint8_t APP_ModbusRegisterFc(uint8_t fc, uint8_t min_len, uint16_t max_qty,
+                             app_modbus_fc_handler_t handler,
+                             app_modbus_post_hook_t post_hook);
+
+/* UID -> map eslemesi ekle/degistir (O(1) lookup). Diagnostics block map'e HR
+ * region olarak eklenir. 1 = OK, 0 = tablo dolu */
+uint8_t APP_ModbusRegisterUnit(uint8_t uid, app_regs_map_t *map);
+
+/* Exception PDU yaz (fc | 0x80, code). Donus: 2 */
+int     APP_ModbusException(uint8_t *resp_pdu, uint8_t fc, uint8_t code);
+
+/* Diagnostics register block (per-FC sayac/cycle). off: blok ici offset */
+uint16_t APP_ModbusDiagRead(uint16_t off, uint16_t *out, uint16_t qty);
+/* Tum FC'ler toplam istek / exception sayaci */
+void     APP_ModbusGetTotals(uint32_t *req, uint32_t *exc);
+
+/* Istek kaynagi (yazma gecmisi): TCP session slot'u 0..APP_MODBUS_MAX_CONN-1 ya da */
+#define APP_MODBUS_SRC_UDP 0xFEu
+
+/* Tek bir MBAP ADU'yu isle, cevap ADU'yu tx'e yaz (tx >= APP_MBAP_MAX_ADU).
+ * Donus: cevap uzunlugu, 0 = cevap yok (bozuk istek). Bilinmeyen UID -> exception 0x0B.
+ * Tum engine'ler (netconn, raw) ayni PDU mantigini kullanir; ayni anda tek context'ten cagrilir.
+ * src: istek kaynagi (session slot / APP_MODBUS_SRC_UDP) */
+uint16_t APP_ModbusServeAdu(const uint8_t *adu, uint16_t adu_len, uint8_t *tx, uint8_t src);
+
+/* Modbus/UDP: tek datagram = tek ADU. Framing dogrulanir, cevap tx'e yazilir.
+ * Donus: cevap uzunlugu, 0 = cevap yok. */
+uint16_t APP_ModbusServeDatagram(const uint8_t *dgram, uint16_t len, uint8_t *tx);
+
+/* Raw API engine (app_modbus_raw.c), APP_MODBUS_ENGINE_RAW secildiginde */
+void    APP_ModbusRawStart(void);
+uint8_t APP_ModbusRawGetConnStats(uint8_t slot, app_modbus_conn_stats_t *out);
 
 #endif
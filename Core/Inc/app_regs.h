@@ -11,18 +11,261 @@
 extern "C" {
 #endif
 
+/* ------------------ register metadata ------------------ */
+
+/* APP_HR_TABLE (app_config.h) alanlari */
+enum { APP_REGS_T_U16 = 0, APP_REGS_T_I16, APP_REGS_T_U32, APP_REGS_T_I32, APP_REGS_T_F32,
+       APP_REGS_T_U64, APP_REGS_T_I64, APP_REGS_T_F64 };
+enum { APP_REGS_A_RW = 0, APP_REGS_A_RO };
+enum { APP_REGS_HOOK_NONE = 0, APP_REGS_HOOK_TIME };
+enum { APP_REGS_R_VOL = 0, APP_REGS_R_RET };
+
+#define APP_REGS_T_WORDS_U16 1u
+#define APP_REGS_T_WORDS_I16 1u
+#define APP_REGS_T_WORDS_U32 2u
+#define APP_REGS_T_WORDS_I32 2u
+#define APP_REGS_T_WORDS_F32 2u
+#define APP_REGS_T_WORDS_U64 4u
+#define APP_REGS_T_WORDS_I64 4u
+#define APP_REGS_T_WORDS_F64 4u
+#define APP_REGS_TYPE_WORDS(t) ((t) >= APP_REGS_T_U64 ? 4u : (t) >= APP_REGS_T_U32 ? 2u : 1u)
+
+/* Word sirasi (APP_REGS_WORD_ORDER) */
+enum { APP_REGS_WO_BE = 0, APP_REGS_WO_WS, APP_REGS_WO_LE };
+
+#define APP_REGS_HOOK_BIT(h) (1u << (h))
+
+/* Adres basina kural (bank->meta[addr]). Sifir-init olmayan varsayilan: U16 0..65535 RW */
+typedef struct {
+  int32_t min;
+  int32_t max;
+  uint8_t type;   /* APP_REGS_T_* */
+  uint8_t access; /* APP_REGS_A_* */
+  uint8_t hook;   /* APP_REGS_HOOK_* */
+  uint8_t part;   /* iki word'luk tiplerde 0 = ilk, 1 = ikinci word */
+  uint8_t retain; /* APP_REGS_R_* */
+} app_regs_meta_t;
+
+/* ------------------ register bank ------------------ */
+
+/* on_write_locked: yazmadan sonra, bank mutex'i tutulurken cagrilir (NULL: yok).
+ * hooks: yazilan adreslerin meta hook'lari (APP_REGS_HOOK_BIT maskesi) */
+typedef void     (*app_regs_write_fn)(uint16_t addr, uint16_t qty, uint32_t hooks);
+
+/* Bir Modbus unit'in holding register banki. Reader'lar lock-free (seq),
+ * writer'lar bank mutex'i ile serilesir. meta NULL: kural yok. */
+typedef struct {
+  uint16_t * volatile    hr;     /* yayinlanan buffer (commit'te shadow ile swap) */
+  uint16_t              *shadow; /* transaction staging, NULL: transaction yok */
+  uint16_t               count;
+  const app_regs_meta_t *meta;
+  app_regs_write_fn      on_write_locked;
+  osMutexId_t            mutex;
+  volatile uint32_t      seq;    /* cift = kararli; her yayin (yazma/commit) +2 */
+  uint32_t               irq_pm; /* write_begin/end arasi saklanan PRIMASK (mutex altinda) */
+
+  /* transaction durumu (mutex altinda; txn_state lock-free okunur) */
+  volatile uint16_t      txn_state; /* TXN_CTRL okumasi: APP_REGS_TXN_IDLE / BEGIN */
+  uint8_t                txn_open;
+  uint8_t                txn_owner; /* BEGIN'i yazan kaynak */
+  uint32_t               txn_t0;
+  uint16_t               txn_lo;
+  uint16_t               txn_hi;
+  uint32_t               txn_hooks;
+} app_regs_bank_t;
+
+/* TXN_CTRL komutlari / durum degerleri */
+enum { APP_REGS_TXN_IDLE = 0, APP_REGS_TXN_BEGIN = 1, APP_REGS_TXN_COMMIT = 2 };
+
+/* Yazan kaynak: Modbus session slot'u / APP_MODBUS_SRC_UDP ya da firmware ici yazma */
+#define APP_REGS_SRC_LOCAL 0xFFu
+/* Yazma donusu: transaction baska bir kaynakta acik (Modbus exception 0x06) */
+#define APP_REGS_BUSY      0xFFFFu
+
+void     APP_RegsBankInit(app_regs_bank_t *b, uint16_t *storage, uint16_t count,
+                          const app_regs_meta_t *meta, app_regs_write_fn on_write_locked,
+                          const char *name);
+/* Bank'a transaction ekler; kontrol word'u bank'in disindadir (APP_RegsMapAddTxn).
+ * TXN_CTRL: BEGIN -> yazmalar shadow'a, COMMIT -> grup tek seferde yayinlanir,
+ * IDLE(0) -> iptal. Okuma: 0 bos, 1 acik.
+ * Transaction BEGIN'i yazan kaynaga aittir; acikken diger Modbus kaynaklarinin
+ * yazmalari APP_REGS_BUSY doner, APP_REGS_SRC_LOCAL yazmalari hemen yayinlanir. */
+void     APP_RegsBankEnableTxn(app_regs_bank_t *b, uint16_t *shadow);
+/* TXN_CTRL yazmasi. Donus: 1 = OK, 0 = gecersiz komut / transaction yok, APP_REGS_BUSY */
+uint16_t APP_RegsBankTxnCtrl(app_regs_bank_t *b, uint8_t src, uint16_t cmd);
+/* TXN_CTRL okumasi (lock-free) */
+uint16_t APP_RegsBankTxnState(const app_regs_bank_t *b);
+/* src'nin acik transaction'ini iptal et (baglanti kapandi) */
+void     APP_RegsBankTxnRelease(app_regs_bank_t *b, uint8_t src);
+/* Periyodik: APP_REGS_TXN_TIMEOUT_MS'i gecen transaction'i iptal et (mutex mesgulse atlar) */
+void     APP_RegsBankTick(app_regs_bank_t *b);
+/* Generation: her yayinlanan yazma/commit'te degisir, tek = yazma suruyor (cevap cache'i) */
+uint32_t APP_RegsBankGeneration(const app_regs_bank_t *b);
+/* Bank* yazmalari dahili (access kontrolu yok); Map* yazmalari Modbus tarafi (RO reddedilir).
+ * src: yazan kaynak (transaction sahipligi icin) */
+uint16_t APP_RegsBankRead(app_regs_bank_t *b, uint16_t addr, uint16_t* out, uint16_t qty);
+uint16_t APP_RegsBankWrite(app_regs_bank_t *b, uint8_t src, uint16_t addr, const uint16_t* in, uint16_t qty);
+uint16_t APP_RegsBankReadWrite(app_regs_bank_t *b, uint8_t src,
+                               uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                               uint16_t raddr, uint16_t* out, uint16_t rqty);
+uint16_t APP_RegsBankMaskWrite(app_regs_bank_t *b, uint8_t src, uint16_t addr, uint16_t and_mask, uint16_t or_mask);
+
+/* ------------------ bit store (coil / discrete input) ------------------ */
+
+#define APP_REGS_BITS_WORDS(n) (((uint32_t)(n) + 31u) / 32u)
+
+/* Packed bit dizisi. Tek bit yazma SRAM bit-band alias'i ile lock-free (bb != NULL),
+ * cok bitli yazma IRQ kapali tek gecis; reader'lar seq ile tutarli, mutex yok. */
+typedef struct {
+  uint32_t          *w;
+  volatile uint32_t *bb;    /* w'nin bit-band alias'i, bit i -> bb[i]; NULL: __atomic fallback */
+  uint16_t           count;
+  volatile uint32_t  seq;
+} app_regs_bits_t;
+
+void     APP_RegsBitsInit(app_regs_bits_t *b, uint32_t *storage, uint16_t count);
+/* Modbus paketleme: out[0] bit0 = addr, LSB once. Donus: qty, 0 = adres hatasi */
+uint16_t APP_RegsBitsRead(app_regs_bits_t *b, uint16_t addr, uint8_t *packed, uint16_t qty);
+uint16_t APP_RegsBitsWrite(app_regs_bits_t *b, uint16_t addr, const uint8_t *packed, uint16_t qty);
+uint16_t APP_RegsBitsSet(app_regs_bits_t *b, uint16_t addr, uint8_t v);
+uint8_t  APP_RegsBitsGet(const app_regs_bits_t *b, uint16_t addr);
+
+/* ------------------ register map (region table) ------------------ */
+
+typedef enum {
+  APP_REGS_COIL = 0,
+  APP_REGS_DI   = 1,
+  APP_REGS_IR   = 2,
+  APP_REGS_HR   = 3,
+  APP_REGS_TABLES
+} app_regs_table_t;
+
+/* Hesaplanan (read-only) region: off = region ici offset. Donus: qty, 0 = hata */
+typedef uint16_t (*app_regs_read_fn)(uint16_t off, uint16_t *out, uint16_t qty);
+
+/* Bir adres penceresi; bank/bits/read/txn'den tam olarak biri dolu */
+typedef struct {
+  uint16_t          start;
+  uint16_t          count;
+  app_regs_bank_t  *bank;  /* IR/HR */
+  app_regs_bits_t  *bits;  /* COIL/DI */
+  app_regs_read_fn  read;  /* IR/HR, read-only */
+  app_regs_bank_t  *txn;   /* HR, tek word: bu bank'in TXN_CTRL'i */
+} app_regs_region_t;
+
+#define APP_REGS_PAGE_COUNT (0x10000u >> APP_REGS_PAGE_SHIFT)
+
+/* RAM: region sayisi kadar + tablo basina APP_REGS_PAGE_COUNT byte index */
+typedef struct {
+  app_regs_region_t region[APP_REGS_TABLES][APP_REGS_MAX_REGIONS];
+  uint8_t           nregion[APP_REGS_TABLES];
+  uint8_t           page[APP_REGS_TABLES][APP_REGS_PAGE_COUNT]; /* region slot + 1, 0 = bos */
+  uint8_t           word_order; /* APP_REGS_WO_*: typed view'lerin Modbus word sirasi */
+} app_regs_map_t;
+
+void    APP_RegsMapInit(app_regs_map_t *m);
+/* Region ekle. 0 = tablo dolu / sayfa cakismasi / gecersiz */
+uint8_t APP_RegsMapAddWords(app_regs_map_t *m, app_regs_table_t t, uint16_t start, app_regs_bank_t *bank);
+uint8_t APP_RegsMapAddBits(app_regs_map_t *m, app_regs_table_t t, uint16_t start, app_regs_bits_t *bits);
+uint8_t APP_RegsMapAddFn(app_regs_map_t *m, app_regs_table_t t, uint16_t start, uint16_t count,
+                         app_regs_read_fn read);
+/* bank'in TXN_CTRL'i HR[start]'a (kendi sayfasinda): yalniz tek word FC03/FC06/FC16 */
+uint8_t APP_RegsMapAddTxn(app_regs_map_t *m, uint16_t start, app_regs_bank_t *bank);
+
+/* [addr, addr+qty) tamamen tek bir region icindeyse o region, yoksa NULL. O(1). */
+const app_regs_region_t *APP_RegsMapFind(const app_regs_map_t *m, app_regs_table_t t,
+                                         uint16_t addr, uint16_t qty);
+
+/* Map uzerinden erisim (Modbus adresi, meta access uygulanir). Donus: qty / 1 = OK, 0 = adres hatasi,
+ * APP_REGS_BUSY = transaction baska kaynakta acik */
+uint16_t APP_RegsMapRead(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint16_t* out, uint16_t qty);
+uint16_t APP_RegsMapWrite(const app_regs_map_t *m, uint8_t src, app_regs_table_t t,
+                          uint16_t addr, const uint16_t* in, uint16_t qty);
+uint16_t APP_RegsMapMaskWrite(const app_regs_map_t *m, uint8_t src, uint16_t addr, uint16_t and_mask, uint16_t or_mask);
+/* FC23: iki aralik ayni bank'taysa atomik, degilse once yaz sonra oku */
+uint16_t APP_RegsMapReadWrite(const app_regs_map_t *m, uint8_t src,
+                              uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                              uint16_t raddr, uint16_t* out, uint16_t rqty);
+uint16_t APP_RegsMapReadBits(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint8_t *packed, uint16_t qty);
+uint16_t APP_RegsMapWriteBits(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, const uint8_t *packed, uint16_t qty);
+uint16_t APP_RegsMapWriteBit(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint8_t v);
+
+/* Ana unit map'i (HR/IR/coil/DI), zone map'leri (sadece HR, yoksa NULL) */
+app_regs_map_t *APP_RegsMainMap(void);
+app_regs_map_t *APP_RegsZoneMap(uint8_t zone);
+
+/* Ana bank (MMM/SS/tarih/log), zone banklari (APP_MODBUS_ZONE_UNIT_COUNT, yoksa NULL) */
+app_regs_bank_t *APP_RegsMainBank(void);
+app_regs_bank_t *APP_RegsZoneBank(uint8_t zone);
+
+/* ------------------ main bank API ------------------ */
+
 void     APP_RegsInit(void);
+/* Supervisor'dan periyodik: terk edilmis transaction'lari zaman asimiyla iptal eder */
+void     APP_RegsTick(void);
+/* Modbus baglantisi kapandi: src'nin acik transaction'i iptal */
+void     APP_RegsTxnRelease(uint8_t src);
 uint16_t APP_RegsReadHR(uint16_t addr);
+/* Tum okumalar mutex almaz (sequence counter + retry); blok okuma tutarli snapshot
+ * dondurur (yarim kalmis bir yazma asla gorunmez). Sadece writer'lar mutex ile serilesir. */
 uint16_t APP_RegsReadHRBlock(uint16_t addr, uint16_t* out, uint16_t qty);
 uint16_t APP_RegsWriteHR(uint16_t addr, uint16_t value);
 uint16_t APP_RegsWriteHRBlock(uint16_t addr, const uint16_t* in, uint16_t qty);
 
+/* FC23: write + read tek mutex/sequence bolgesinde. 1 = OK, 0 = adres hatasi */
+uint16_t APP_RegsReadWriteHRBlock(uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                                  uint16_t raddr, uint16_t* out, uint16_t rqty);
+/* FC22: atomik AND/OR mask write. 1 = OK, 0 = adres hatasi */
+uint16_t APP_RegsMaskWriteHR(uint16_t addr, uint16_t and_mask, uint16_t or_mask);
+
 void     APP_RegsGetTime(uint16_t* minutes, uint16_t* seconds);
 void     APP_RegsGetDate(uint16_t* year, uint16_t* month, uint16_t* day);
 uint8_t  APP_RegsGetLogEnable(void);
 
-/* MMM/SS değiştiyse 1 kere true döner, sonra dirty bayrağı temizlenir */
-bool     APP_RegsConsumeChangedTime(uint16_t *mmm, uint16_t *ss);
+/* APP_HR_TABLE'dan derleme zamaninda uretilen CSV (name,addr,type,min,max,access,hook,retain) */
+const char *APP_RegsMetaCsv(uint32_t *len);
+/* Ana bank'in adres kurali (NULL: aralik disi) */
+const app_regs_meta_t *APP_RegsMetaGet(uint16_t addr);
+/* Retentive (ret = RET) HR bitmap'i (mask: APP_REGS_HR_WORDS) */
+void     APP_RegsRetainMask(uint32_t *mask);
+
+/* ------------------ typed views (32/64-bit) ------------------ */
+
+/* Ham word'ler <-> deger (nwords 1..4, order APP_REGS_WO_*). Snapshot okunmus bloklari
+ * (log payload gibi) ikinci okuma yapmadan cozmek icin. */
+uint64_t APP_RegsWordsToU64(const uint16_t *w, uint8_t nwords, uint8_t order);
+void     APP_RegsU64ToWords(uint64_t v, uint16_t *w, uint8_t nwords, uint8_t order);
+
+/* Tek seq okuma / tek seq yazma: deger hicbir zaman yarim gorunmez.
+ * Map'in word_order'i uygulanir. Set* dahili yazmadir (access kontrolu yok). 1 = OK */
+uint8_t  APP_RegsMapGetU32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint32_t *out);
+uint8_t  APP_RegsMapSetU32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint32_t v);
+uint8_t  APP_RegsMapGetF32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, float *out);
+uint8_t  APP_RegsMapSetF32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, float v);
+uint8_t  APP_RegsMapGetU64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint64_t *out);
+uint8_t  APP_RegsMapSetU64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint64_t v);
+uint8_t  APP_RegsMapGetF64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, double *out);
+uint8_t  APP_RegsMapSetF64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, double v);
+
+/* Ana map HR kisayollari (log / P10). Adres hatasinda 0 */
+uint32_t APP_RegsGetU32(uint16_t addr);
+int32_t  APP_RegsGetI32(uint16_t addr);
+float    APP_RegsGetF32(uint16_t addr);
+
+/* ------------------ change notification (ana HR bank) ------------------ */
+
+#define APP_REGS_HR_WORDS    APP_REGS_BITS_WORDS(APP_MODBUS_HR_COUNT)
+/* Subscriber task'in bekledigi varsayilan thread flag */
+#define APP_REGS_NOTIFY_FLAG 0x0100u
+
+/* Cagiran task'i subscriber yapar: watch bitmap'indeki HR'lerden biri degisince
+ * task'a flag set edilir. Donus: subscriber id, -1 = tablo dolu */
+int8_t   APP_RegsSubscribe(uint32_t flag, const uint32_t *watch);
+/* watch = metadata'da hook'u verilen ID olan register'lar (APP_REGS_HOOK_*) */
+int8_t   APP_RegsSubscribeHook(uint32_t flag, uint8_t hook);
+/* Birikmis degisiklikleri al ve temizle (changed: APP_REGS_HR_WORDS, NULL olabilir).
+ * 1 = en az bir watch register'i degisti */
+uint8_t  APP_RegsTakeChanges(int8_t id, uint32_t *changed);
 
 #ifdef __cplusplus
 }
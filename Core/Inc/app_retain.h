@@ -0,0 +1,36 @@
+#ifndef APP_RETAIN_H
+#define APP_RETAIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Retentive HR kaynagi (APP_RetainInit sonucu) */
+typedef enum {
+  APP_RETAIN_SRC_DEFAULT = 0, /* gecerli kopya yok, APP_RegsInit varsayilanlari */
+  APP_RETAIN_SRC_BKPSRAM,
+  APP_RETAIN_SRC_FLASH
+} app_retain_src_t;
+
+typedef struct {
+  uint8_t  source;       /* app_retain_src_t */
+  uint32_t flushes;      /* flash'a toplu yazma sayisi (coalesced) */
+  uint32_t words;        /* programlanan flash word'u (header + record) */
+  uint32_t erases;       /* sektor silme (compaction) */
+  uint32_t changes;      /* backup SRAM'e yansitilan degisiklik olayi */
+  uint32_t errors;       /* basarisiz flush (program/erase hatasi; pending kalir) */
+  uint32_t erase_max_us; /* en uzun sektor silme (flash'tan calisan her sey bu kadar durur) */
+} app_retain_stats_t;
+
+/* APP_RegsInit'ten hemen sonra: backup SRAM / flash'tan retentive HR'leri geri yukler */
+void    APP_RetainInit(void);
+void    APP_RetainTask(void *argument);
+uint8_t APP_RetainGetStats(app_retain_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_RETAIN_H */
@@ -0,0 +1,25 @@
+#ifndef APP_RETAIN_FLASH_H
+#define APP_RETAIN_FLASH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Retain flash log'unun donanim katmani (app_retain.c sadece bunlari kullanir;
+ * host testinde Tests/stubs/flash_sim.c ile degistirilir). */
+
+void     APP_RetainFlUnlock(void);
+void     APP_RetainFlLock(void);
+/* Hizalanmis 32-bit okuma */
+uint32_t APP_RetainFlRead(uint32_t addr);
+/* 1 = OK. Program sadece 1 -> 0 bitleri degistirir, erase sektoru 0xFF yapar */
+uint8_t  APP_RetainFlProgram(uint32_t addr, uint32_t w);
+uint8_t  APP_RetainFlErase(uint32_t sector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_RETAIN_FLASH_H */
@@ -11,6 +11,7 @@ typedef enum {
   APP_KICK_MODBUS = 0,
   APP_KICK_LOG    = 1,
   APP_KICK_P10    = 2,
+  APP_KICK_LOGWR  = 3, /* log writer (SD I/O); takilan f_write/f_sync reset'e gider */
   APP_KICK_MAX
 } app_kick_source_t;
 
@@ -0,0 +1,130 @@
+#include "app_hist.h"
+#include "app_config.h"
+
+#if APP_HIST_ENABLE
+
+#include "cmsis_os.h"
+
+#include <string.h>
+
+/* 12 byte kayit; ring CCMRAM'de (DMA gerekmiyor, ana RAM'i yemez) */
+typedef struct {
+  uint32_t t_ms;
+  uint16_t addr;
+  uint16_t value;
+  uint8_t  unit;
+  uint8_t  src;
+  uint8_t  table;
+  uint8_t  fc;
+} hist_entry_t;
+
+_Static_assert(sizeof(hist_entry_t) == APP_HIST_ENTRY_WORDS * 2u, "hist_entry_t boyutu");
+/* Modbus file record numarasi 0..9999 */
+_Static_assert(APP_HIST_COUNT * APP_HIST_ENTRY_WORDS <= 10000u, "APP_HIST_COUNT FC20 record araligini asiyor");
+
+#define HIST_VERSION 2u
+#define HIST_MAGIC   0x48535431u /* "HST1" */
+#define HIST_LAYOUT  ((HIST_VERSION << 24) | ((uint32_t)APP_HIST_COUNT << 8) | (uint32_t)sizeof(hist_entry_t))
+
+/*
+ * NOLOAD: startup sifirlamaz. Warm reset (watchdog, hard fault, NVIC reset) sonrasi
+ * gecmis korunur: reset'ten hemen onceki yazmalar teshis icin okunabilir. Soguk
+ * aciliste CCMRAM rastgele -> magic/layout tutmaz, ring temizlenir.
+ * total tek 32-bit store ile ilerler (kayit once yazilir); head = total % kapasite
+ * oldugu icin yarida kalan append header'i bozamaz, en fazla o slot'u yarim birakir.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t layout;
+  uint32_t total;
+} hist_hdr_t;
+
+static hist_hdr_t   s_hdr __attribute__((section(".ccmram_noinit")));
+static hist_entry_t s_ring[APP_HIST_COUNT] __attribute__((section(".ccmram_noinit")));
+static uint16_t     s_head;       /* total % APP_HIST_COUNT */
+static uint32_t     s_boot_total; /* bu boot'taki ilk kaydin sira numarasi */
+
+void APP_HistInit(void)
+{
+  if (s_hdr.magic != HIST_MAGIC || s_hdr.layout != HIST_LAYOUT) {
+    memset(s_ring, 0, sizeof(s_ring));
+    s_hdr.total  = 0;
+    s_hdr.layout = HIST_LAYOUT;
+    s_hdr.magic  = HIST_MAGIC;
+  }
+  s_head       = (uint16_t)(s_hdr.total % APP_HIST_COUNT);
+  s_boot_total = s_hdr.total;
+}
+
+void APP_HistAppend(uint8_t unit, uint8_t table, uint8_t fc, uint8_t src,
+                    uint16_t addr, uint16_t value)
+{
+  hist_entry_t *e = &s_ring[s_head];
+  e->t_ms  = osKernelGetTickCount();
+  e->addr  = addr;
+  e->value = value;
+  e->unit  = unit;
+  e->src   = src;
+  e->table = table;
+  e->fc    = fc;
+
+  s_head = (uint16_t)((s_head + 1u < APP_HIST_COUNT) ? s_head + 1u : 0u);
+  s_hdr.total++;
+}
+
+static uint16_t hdr_word(uint16_t w)
+{
+  const uint32_t now = osKernelGetTickCount();
+  switch (w) {
+    case APP_HIST_HDR_VERSION:     return HIST_VERSION;
+    case APP_HIST_HDR_ENTRY_WORDS: return APP_HIST_ENTRY_WORDS;
+    case APP_HIST_HDR_CAPACITY:    return (uint16_t)APP_HIST_COUNT;
+    case APP_HIST_HDR_TOTAL_HI:    return (uint16_t)(s_hdr.total >> 16);
+    case APP_HIST_HDR_TOTAL_LO:    return (uint16_t)s_hdr.total;
+    case APP_HIST_HDR_HEAD:        return s_head;
+    case APP_HIST_HDR_NOW_HI:      return (uint16_t)(now >> 16);
+    case APP_HIST_HDR_NOW_LO:      return (uint16_t)now;
+    case APP_HIST_HDR_BOOT_HI:     return (uint16_t)(s_boot_total >> 16);
+    case APP_HIST_HDR_BOOT_LO:     return (uint16_t)s_boot_total;
+    default:                       return 0;
+  }
+}
+
+static uint16_t entry_word(const hist_entry_t *e, uint16_t w)
+{
+  switch (w) {
+    case 0:  return (uint16_t)(e->t_ms >> 16);
+    case 1:  return (uint16_t)e->t_ms;
+    case 2:  return e->addr;
+    case 3:  return e->value;
+    case 4:  return (uint16_t)(((uint16_t)e->unit << 8) | e->src);
+    default: return (uint16_t)(((uint16_t)e->table << 8) | e->fc);
+  }
+}
+
+uint16_t APP_HistReadFile(uint16_t file, uint16_t rec, uint16_t *out, uint16_t qty)
+{
+  if (!out || qty == 0) return 0;
+
+  if (file == APP_HIST_FILE_HDR) {
+    if ((uint32_t)rec + qty > APP_HIST_HDR_WORDS) return 0;
+    for (uint16_t i = 0; i < qty; ++i) out[i] = hdr_word((uint16_t)(rec + i));
+    return qty;
+  }
+
+  if (file == APP_HIST_FILE_DATA) {
+    if ((uint32_t)rec + qty > APP_HIST_COUNT * APP_HIST_ENTRY_WORDS) return 0;
+
+    uint16_t slot = (uint16_t)(rec / APP_HIST_ENTRY_WORDS);
+    uint16_t w    = (uint16_t)(rec % APP_HIST_ENTRY_WORDS);
+    for (uint16_t i = 0; i < qty; ++i) {
+      out[i] = entry_word(&s_ring[slot], w);
+      if (++w == APP_HIST_ENTRY_WORDS) { w = 0; slot++; }
+    }
+    return qty;
+  }
+
+  return 0;
+}
+
+#endif /* APP_HIST_ENABLE */
@@ -9,26 +9,20 @@
 
 #include "fatfs.h"
 #include "ff.h"
+#include "diskio.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
-typedef struct {
-  uint32_t tick_ms;
-  uint16_t minutes;
-  uint16_t seconds;
-} log_evt_t;
+/* MMM/SS + payload tek seq snapshot'ta okunur: HR0..payload sonu */
+#define LOG_SNAP_COUNT (APP_LOG_PAYLOAD_START_HR + APP_LOG_PAYLOAD_COUNT_HR)
+_Static_assert(LOG_SNAP_COUNT <= APP_MODBUS_HR_COUNT, "log payload HR map disinda");
 
-static osMessageQueueId_t g_log_q;
 static FATFS g_fs;
 static uint8_t g_fs_mounted = 0;
 
-static FIL g_file;
-static uint8_t g_file_open = 0;
-static uint16_t g_open_y = 0;
-static uint8_t g_open_m = 0;
-static uint8_t g_open_d = 0;
+static app_log_stats_t g_stats;
 
 static bool date_valid(uint16_t y, uint8_t m, uint8_t d)
 {
@@ -38,12 +32,304 @@ static bool date_valid(uint16_t y, uint8_t m, uint8_t d)
   return true;
 }
 
-static void close_file(void)
+#if (APP_LOG_FORMAT == APP_LOG_FORMAT_BIN) || APP_LOG_SMP_ENABLE
+
+/* CRC16/MODBUS (poly 0xA001, init 0xFFFF): BIN ve SMP record/header'lari */
+static uint16_t crc16(const uint8_t *p, uint32_t n)
+{
+  uint16_t crc = 0xFFFFu;
+  for (uint32_t i = 0; i < n; ++i) {
+    crc ^= p[i];
+    for (uint8_t k = 0; k < 8u; ++k) crc = (crc & 1u) ? (uint16_t)((crc >> 1) ^ 0xA001u) : (uint16_t)(crc >> 1);
+  }
+  return crc;
+}
+
+static inline uint8_t *put16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static inline uint8_t *put32(uint8_t *p, uint32_t v)
+{
+  return put16(put16(p, (uint16_t)v), (uint16_t)(v >> 16));
+}
+
+#endif
+
+/* ------------------ writer streams ------------------ */
+
+/*
+ * Writer'in gunluk dosya akislari; FatFs'e yalnizca writer task dokunur.
+ *  ROW: MMM/SS degisim satiri, logs/YYYYMMDD.CSV / .BIN (APP_LOG_FORMAT)
+ *  SMP: sampler kanallari, logs/YYYYMMDD.SMP (APP_LOG_SMP_ENABLE)
+ */
+enum { LOG_STREAM_ROW = 0,
+#if APP_LOG_SMP_ENABLE
+       LOG_STREAM_SMP,
+#endif
+       LOG_STREAM_COUNT };
+
+#if APP_LOG_PREALLOC_BYTES
+#define LOG_SS          512u
+#define LOG_FA_MODIFIED 0x40u /* ff.c FA_MODIFIED (R0.12c): f_sync dir entry'yi yazsin */
+
+typedef struct {
+  uint8_t tail[LOG_SS]; /* son yarim sektor; basta: DMA icin 4-byte hizali */
+  DWORD   sect0;        /* dosyanin ilk data sektoru */
+  DWORD   sects;        /* cluster zincirinin sektor sayisi */
+  FSIZE_t pos;          /* yazilan byte = dosya boyu */
+  uint8_t active;
+} log_seg_t;
+#endif
+
+typedef struct {
+  uint8_t  stage[APP_LOG_BUF_SIZE]; /* basta: SDIO DMA icin 4-byte hizali (SRAM) */
+#if APP_LOG_PREALLOC_BYTES
+  log_seg_t seg;
+#endif
+  FIL      file;
+  const char *ext;                  /* 8.3 uzanti */
+  FSIZE_t  prealloc;                /* 0: on-tahsis yok */
+  uint32_t stage_len;
+  uint32_t stage_limit;
+  uint32_t stage_recs;
+  uint32_t unsynced_t0;
+  uint16_t open_y;
+  uint8_t  open_m;
+  uint8_t  open_d;
+  uint8_t  open;
+  uint8_t  unsynced;                /* son sync'ten beri record var */
+} log_stream_t;
+
+static log_stream_t s_st[LOG_STREAM_COUNT] __attribute__((aligned(4)));
+
+/* Acik kalan akis dosyalari + APP_LogReadAt + dizin taramasi (seg_trim_stale) ayni anda */
+_Static_assert(_FS_LOCK == 0 || _FS_LOCK >= LOG_STREAM_COUNT + 2,
+               "ffconf.h _FS_LOCK log akislarina yetmiyor (CubeMX yeniden uretince kontrol et)");
+
+/* ------------------ contiguous daily file (f_expand) ------------------ */
+
+#if APP_LOG_PREALLOC_BYTES
+
+/*
+ * Gun dosyasi ilk acilista st->prealloc kadar tek parca ayrilir. Append'ler
+ * FatFs'i atlayip diskio ile dogrudan bilinen sektor araligina gider: cluster sinirinda
+ * FAT guncellemesi yok, yarim kalan son sektor seg.tail'de tutulur. Dir entry'deki
+ * boy yalnizca sync'te (log_sync) yazilir; gun bitince kullanilmayan cluster'lar
+ * f_truncate ile birakilir. Ayni gun yeniden acilista (reboot) zincir fast-seek
+ * link map ile dogrulanir: tek fragment ve bos yer varsa kaldigi yerden devam eder.
+ * On-tahsis dolarsa / contiguous yer bulunamazsa klasik f_write append'e doner.
+ */
+#if _FATFS != 68300
+#error "seg_* FatFs R0.12c ic yapisina dokunuyor (obj.objsize, cltbl, FA_MODIFIED, database/csize): FatFs degisince gozden gecir"
+#endif
+#if !_USE_EXPAND
+#error "APP_LOG_PREALLOC_BYTES icin ffconf.h _USE_EXPAND 1 olmali (CubeMX yeniden uretince kontrol et)"
+#endif
+#if !_USE_FASTSEEK
+#error "APP_LOG_PREALLOC_BYTES icin ffconf.h _USE_FASTSEEK 1 olmali"
+#endif
+
+static bool seg_attach(log_stream_t *st)
+{
+  log_seg_t *sg = &st->seg;
+  sg->active = 0;
+  if (st->prealloc == 0) return false;
+
+  const FSIZE_t size = f_size(&st->file);
+  if (size == 0 && f_expand(&st->file, st->prealloc, 1) != FR_OK) return false;
+
+  // tek fragment mi? link map: {tablo boyu, ncl, ilk cluster, 0}
+  DWORD tbl[4] = { 4u };
+  st->file.cltbl = tbl;
+  const FRESULT fr = f_lseek(&st->file, CREATE_LINKMAP);
+  st->file.cltbl = NULL;
+
+  st->file.obj.objsize = size; // f_expand dosya boyunu tahsise cekiyor; mantiksal boy pos
+  if (fr != FR_OK || tbl[1] == 0) return false;
+
+  sg->sect0 = g_fs.database + (tbl[2] - 2u) * g_fs.csize;
+  sg->sects = tbl[1] * g_fs.csize;
+  sg->pos = size;
+  if ((FSIZE_t)sg->sects * LOG_SS <= size) return false;
+
+  if ((size % LOG_SS) != 0u &&
+      disk_read(g_fs.drv, sg->tail, sg->sect0 + (DWORD)(size / LOG_SS), 1) != RES_OK) {
+    return false;
+  }
+  sg->active = 1;
+  return true;
+}
+
+/* Donus: yazilan byte; tahsis biterse kisa doner */
+static UINT seg_write(log_seg_t *sg, const uint8_t *p, UINT len)
+{
+  const FSIZE_t end = (FSIZE_t)sg->sects * LOG_SS;
+  UINT done = 0;
+
+  while (done < len && sg->pos < end) {
+    const UINT off = (UINT)(sg->pos % LOG_SS);
+    const DWORD sect = sg->sect0 + (DWORD)(sg->pos / LOG_SS);
+    const UINT left = len - done;
+
+    if (off == 0u && left >= LOG_SS && (((uintptr_t)(p + done) & 3u) == 0u)) {
+      // tam sektorler dogrudan buffer'dan (multi-block)
+      UINT n = left / LOG_SS;
+      const DWORD room = (DWORD)((end - sg->pos) / LOG_SS);
+      if (n > room) n = (UINT)room;
+      if (disk_write(g_fs.drv, p + done, sect, n) != RES_OK) break;
+      sg->pos += (FSIZE_t)n * LOG_SS;
+      done += n * LOG_SS;
+      continue;
+    }
+
+    UINT n = LOG_SS - off;
+    if (n > left) n = left;
+    memcpy(&sg->tail[off], p + done, n);
+    if (off + n == LOG_SS && disk_write(g_fs.drv, sg->tail, sect, 1) != RES_OK) break;
+    sg->pos += n;
+    done += n;
+  }
+  return done;
+}
+
+static void seg_sync(log_stream_t *st)
+{
+  log_seg_t *sg = &st->seg;
+  if ((sg->pos % LOG_SS) != 0u) {
+    (void)disk_write(g_fs.drv, sg->tail, sg->sect0 + (DWORD)(sg->pos / LOG_SS), 1);
+  }
+  st->file.obj.objsize = sg->pos;
+  st->file.flag |= LOG_FA_MODIFIED;
+  (void)f_sync(&st->file);
+}
+
+/* Klasik append'e don: fptr/clust zincirde pos'a tasinir; trim: kalan cluster'lari birak */
+static void seg_detach(log_stream_t *st, bool trim)
+{
+  log_seg_t *sg = &st->seg;
+  if (!sg->active) return;
+  seg_sync(st);
+  sg->active = 0;
+
+  st->file.obj.objsize = (FSIZE_t)sg->sects * LOG_SS; // lseek zincir icinde kalsin (expand etmesin)
+  (void)f_lseek(&st->file, sg->pos);
+  if (trim) (void)f_truncate(&st->file);
+  else st->file.obj.objsize = sg->pos;
+}
+
+/*
+ * Gun degisimi reboot'a denk gelirse onceki gunun dosyasi close_file(final)'i gormez:
+ * on-tahsisi (boyundan uzun tek fragment zincir) diskte kalir. Yeni gun dosyasi
+ * olusturulmadan once ayni uzantinin bugunden onceki en yeni dosyasi (son acilan)
+ * kontrol edilir, fazla cluster'lar seg_detach gibi f_truncate ile birakilir.
+ * st->file o sirada kapali: FIL stack'e alinmaz.
+ */
+static void seg_trim_stale(log_stream_t *st, uint16_t y, uint8_t m, uint8_t d)
+{
+  const uint32_t today = (uint32_t)y * 10000u + (uint32_t)m * 100u + d;
+  uint32_t best = 0;
+  char name[13];
+  DIR dir;
+  FILINFO fi;
+
+  if (f_opendir(&dir, APP_LOG_DIR) != FR_OK) return;
+  while (f_readdir(&dir, &fi) == FR_OK && fi.fname[0] != 0) {
+    // YYYYMMDD.<ext>
+    if ((fi.fattrib & AM_DIR) || fi.fname[8] != '.' || strcmp(&fi.fname[9], st->ext) != 0) continue;
+    uint32_t date = 0;
+    uint8_t i = 0;
+    for (; i < 8u && fi.fname[i] >= '0' && fi.fname[i] <= '9'; ++i) date = date * 10u + (uint32_t)(fi.fname[i] - '0');
+    if (i != 8u || date >= today || date <= best) continue;
+    best = date;
+    memcpy(name, fi.fname, sizeof(name));
+  }
+  (void)f_closedir(&dir);
+  if (best == 0) return;
+
+  char path[32];
+  snprintf(path, sizeof(path), "%s/%s", APP_LOG_DIR, name);
+  if (f_open(&st->file, path, FA_OPEN_EXISTING | FA_WRITE) != FR_OK) return;
+
+  const FSIZE_t size = f_size(&st->file);
+  DWORD tbl[4] = { 4u };
+  st->file.cltbl = tbl;
+  const FRESULT fr = f_lseek(&st->file, CREATE_LINKMAP);
+  st->file.cltbl = NULL;
+
+  // parcali zincir on-tahsis degil (f_write ile buyudu): dokunma
+  const FSIZE_t alloc = (FSIZE_t)tbl[1] * g_fs.csize * LOG_SS;
+  if (fr == FR_OK && alloc >= size + (FSIZE_t)g_fs.csize * LOG_SS) {
+    st->file.obj.objsize = alloc; // lseek zincir icinde kalsin
+    (void)f_lseek(&st->file, size);
+    (void)f_truncate(&st->file);
+    g_stats.trims++;
+  }
+  (void)f_close(&st->file);
+}
+
+#endif /* APP_LOG_PREALLOC_BYTES */
+
+static FRESULT log_write(log_stream_t *st, const void *p, UINT len)
+{
+  UINT done = 0;
+#if APP_LOG_PREALLOC_BYTES
+  if (st->seg.active) {
+    done = seg_write(&st->seg, (const uint8_t *)p, len);
+    if (done == len) return FR_OK;
+    if (st->seg.pos < (FSIZE_t)st->seg.sects * LOG_SS) return FR_DISK_ERR;
+    seg_detach(st, false); // on-tahsis doldu: kalani zinciri uzatarak
+  }
+#endif
+  UINT bw = 0;
+  const FRESULT fr = f_write(&st->file, (const uint8_t *)p + done, len - done, &bw);
+  return (fr == FR_OK && bw != len - done) ? FR_DENIED : fr;
+}
+
+static void log_sync(log_stream_t *st)
 {
-  if (!g_file_open) return;
-  (void)f_sync(&g_file);
-  (void)f_close(&g_file);
-  g_file_open = 0;
+#if APP_LOG_PREALLOC_BYTES
+  if (st->seg.active) {
+    seg_sync(st);
+    return;
+  }
+#endif
+  (void)f_sync(&st->file);
+}
+
+static FSIZE_t log_tell(log_stream_t *st)
+{
+#if APP_LOG_PREALLOC_BYTES
+  if (st->seg.active) return st->seg.pos;
+#endif
+  return f_tell(&st->file);
+}
+
+/* final: gun bitti, on-tahsisin kullanilmayan kismi birakilir */
+static void close_file(log_stream_t *st, bool final)
+{
+  if (!st->open) return;
+#if APP_LOG_PREALLOC_BYTES
+  if (st->seg.active) {
+    if (final) seg_detach(st, true);
+    else seg_sync(st);
+    st->seg.active = 0;
+  }
+#else
+  (void)final;
+#endif
+  (void)f_sync(&st->file);
+  (void)f_close(&st->file);
+  st->open = 0;
+}
+
+/* 8.3 (_USE_LFN 0): logs/YYYYMMDD.<ext> */
+static void log_path(char *path, size_t cap, uint16_t y, uint8_t m, uint8_t d, const char *ext)
+{
+  snprintf(path, cap, "%s/%04u%02u%02u.%s", APP_LOG_DIR, (unsigned)y, (unsigned)m, (unsigned)d, ext);
 }
 
 static void ensure_log_dir(void)
@@ -54,82 +340,755 @@ static void ensure_log_dir(void)
   (void)fr;
 }
 
-static bool open_daily_file(uint16_t y, uint8_t m, uint8_t d)
+#if APP_LOG_FORMAT == APP_LOG_FORMAT_BIN
+
+/*
+ * Binary log (little-endian). Dosya = [header, record...] segmentleri; her acilista
+ * yeni header yazilir (firmware/config degisse de dosya kendini tarif eder).
+ *  header: "MBL1", u16 header_len, u16 record_len, u16 payload_count, u8 word_order,
+ *          u8 reserved, u16 addr[payload_count], u8 type[payload_count] (APP_REGS_T_*),
+ *          (cift uzunluga pad), u16 crc16 (onceki tum byte'lar)
+ *  record: u32 tick_ms, u16 minutes, u16 seconds, u16 payload[payload_count], u16 crc16
+ */
+#define LOG_BIN_MAGIC   "MBL1"
+#define LOG_BIN_REC_LEN (8u + 2u * APP_LOG_PAYLOAD_COUNT_HR + 2u)
+#define LOG_BIN_HDR_LEN (12u + 2u * APP_LOG_PAYLOAD_COUNT_HR + ((APP_LOG_PAYLOAD_COUNT_HR + 1u) & ~1u) + 2u)
+
+static void write_bin_header(log_stream_t *st)
+{
+  uint8_t h[LOG_BIN_HDR_LEN];
+  memset(h, 0, sizeof(h));
+
+  memcpy(h, LOG_BIN_MAGIC, 4);
+  uint8_t *p = put16(&h[4], (uint16_t)LOG_BIN_HDR_LEN);
+  p = put16(p, (uint16_t)LOG_BIN_REC_LEN);
+  p = put16(p, (uint16_t)APP_LOG_PAYLOAD_COUNT_HR);
+  *p++ = APP_RegsMainMap()->word_order;
+  *p++ = 0;
+  for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) p = put16(p, (uint16_t)(APP_LOG_PAYLOAD_START_HR + i));
+  for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) {
+    const app_regs_meta_t *m = APP_RegsMetaGet((uint16_t)(APP_LOG_PAYLOAD_START_HR + i));
+    p[i] = m ? m->type : APP_REGS_T_U16;
+  }
+  (void)put16(&h[sizeof(h) - 2u], crc16(h, sizeof(h) - 2u));
+
+  (void)log_write(st, h, sizeof(h));
+}
+
+static UINT fmt_bin_record(uint8_t *rec, uint32_t tick_ms, const uint16_t *snap)
+{
+  uint8_t *p = put32(rec, tick_ms);
+  p = put16(p, snap[APP_HR_MINUTES]);
+  p = put16(p, snap[APP_HR_SECONDS]);
+  for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) p = put16(p, snap[APP_LOG_PAYLOAD_START_HR + i]);
+  (void)put16(p, crc16(rec, LOG_BIN_REC_LEN - 2u));
+  return (UINT)LOG_BIN_REC_LEN;
+}
+
+#else /* APP_LOG_FORMAT_CSV */
+
+static int fmt_u64(char *p, size_t cap, uint64_t v, bool neg)
 {
-  if (g_file_open && g_open_y == y && g_open_m == m && g_open_d == d) {
+  char t[21];
+  int k = 0;
+  do { t[k++] = (char)('0' + (v % 10u)); v /= 10u; } while (v != 0 && k < (int)sizeof(t));
+  if (neg) t[k++] = '-';
+  if ((size_t)k + 1u > cap) return 0;
+  for (int i = 0; i < k; ++i) p[i] = t[k - 1 - i];
+  p[k] = '\0';
+  return k;
+}
+
+// float: 3 ondalik, printf float desteginden bagimsiz
+static int fmt_real(char *p, size_t cap, double f)
+{
+  if (!(f == f) || f > 1e15 || f < -1e15) return snprintf(p, cap, "nan");
+  const bool neg = (f < 0);
+  const uint64_t x = (uint64_t)((neg ? -f : f) * 1000.0 + 0.5);
+  int n = fmt_u64(p, cap, x / 1000u, neg);
+  n += snprintf(p + n, cap - (size_t)n, ".%03u", (unsigned)(x % 1000u));
+  return n;
+}
+
+/*
+ * payload[i]'den baslayan degeri metadata tipine gore yaz (",<deger>").
+ * Cok word'lu tipler snapshot'tan dogrudan cozulur; devam word'lerinin kolonlari bos.
+ * Donus: tuketilen word sayisi.
+ */
+static uint16_t fmt_payload(char *line, size_t cap, int *n, const uint16_t *payload, uint16_t i)
+{
+  const app_regs_meta_t *m = APP_RegsMetaGet((uint16_t)(APP_LOG_PAYLOAD_START_HR + i));
+  const uint8_t type = m ? m->type : APP_REGS_T_U16;
+  const uint8_t words = APP_REGS_TYPE_WORDS(type);
+
+  if ((m && m->part != 0) || i + words > APP_LOG_PAYLOAD_COUNT_HR) {
+    *n += snprintf(line + *n, cap - (size_t)*n, ",%u", (unsigned)payload[i]); // yarim deger: ham word
+    return 1;
+  }
+
+  char v[32];
+  const uint64_t u = APP_RegsWordsToU64(&payload[i], words, APP_RegsMainMap()->word_order);
+  if (type == APP_REGS_T_F32) {
+    const uint32_t b = (uint32_t)u;
+    float f;
+    memcpy(&f, &b, sizeof(f));
+    fmt_real(v, sizeof(v), f);
+  } else if (type == APP_REGS_T_F64) {
+    double f;
+    memcpy(&f, &u, sizeof(f));
+    fmt_real(v, sizeof(v), f);
+  } else if (type == APP_REGS_T_I16 || type == APP_REGS_T_I32 || type == APP_REGS_T_I64) {
+    const int64_t sv = (type == APP_REGS_T_I16) ? (int64_t)(int16_t)u
+                     : (type == APP_REGS_T_I32) ? (int64_t)(int32_t)u : (int64_t)u;
+    fmt_u64(v, sizeof(v), (sv < 0) ? (uint64_t)0 - (uint64_t)sv : (uint64_t)sv, sv < 0);
+  } else {
+    fmt_u64(v, sizeof(v), u, false);
+  }
+  *n += snprintf(line + *n, cap - (size_t)*n, ",%s", v);
+  for (uint8_t k = 1; k < words; ++k) *n += snprintf(line + *n, cap - (size_t)*n, ",");
+  return words;
+}
+
+static UINT fmt_csv_record(char *line, size_t cap, uint32_t tick_ms, const uint16_t *snap)
+{
+  const uint16_t *payload = &snap[APP_LOG_PAYLOAD_START_HR];
+
+  int n = snprintf(line, cap, "%lu,%u,%u",
+                   (unsigned long)tick_ms,
+                   (unsigned)snap[APP_HR_MINUTES],
+                   (unsigned)snap[APP_HR_SECONDS]);
+  for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ) {
+    i = (uint16_t)(i + fmt_payload(line, cap, &n, payload, i));
+  }
+  n += snprintf(line + n, cap - (size_t)n, "\r\n");
+  return (UINT)strlen(line);
+}
+
+static void write_csv_header(log_stream_t *st)
+{
+#if (APP_LOG_PAYLOAD_COUNT_HR == 10) && (APP_LOG_PAYLOAD_START_HR == 6)
+  static const char hdr[] = "tick_ms,minutes,seconds,hr6,hr7,hr8,hr9,hr10,hr11,hr12,hr13,hr14,hr15\r\n";
+#else
+  // generic header
+  char hdr[256];
+  int n = snprintf(hdr, sizeof(hdr), "tick_ms,minutes,seconds");
+  for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) {
+    n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, ",hr%u", (unsigned)(APP_LOG_PAYLOAD_START_HR + i));
+  }
+  n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, "\r\n");
+#endif
+#if (APP_LOG_PAYLOAD_COUNT_HR == 10) && (APP_LOG_PAYLOAD_START_HR == 6)
+  (void)log_write(st, hdr, sizeof(hdr) - 1);
+#else
+  (void)log_write(st, hdr, (UINT)strlen(hdr));
+#endif
+}
+
+#endif /* APP_LOG_FORMAT */
+
+/* ------------------ sampler channels ------------------ */
+
+/* Ring slot'u: ROW icin HR0..LOG_SNAP_COUNT snapshot'i, SMP icin kanal register'lari */
+#define LOG_SLOT_WORDS APP_MODBUS_HR_COUNT
+_Static_assert(LOG_SNAP_COUNT <= LOG_SLOT_WORDS, "ROW snapshot slot'a sigmiyor");
+
+#if APP_LOG_SMP_ENABLE
+
+/*
+ * Sampler: her kanal APP_LOG_SMP_TICK_HZ'in bir boleninde (10..100 Hz) kendi HR
+ * listesini ornekler. Tick TIM7 ISR'inden (APP_LogSamplerTickISR) gelir; log task
+ * tick basina ana bank'in tamamini tek seq snapshot'ta okur (32 word) ve zamani
+ * gelen kanallarin register'larini ring'e koyar.
+ *
+ * Deadband: ':' ile esik verilen register'lar tetiktir. Kanalda tetik varsa satir
+ * yalnizca en az biri son yazilan degerinden esikten fazla saptiginda yazilir
+ * (degismeyen degerler ring/SD maliyeti uretmez); tetiksiz kanal her periyotta yazilir.
+ * I16 register'larda fark isaretli hesaplanir.
+ *
+ * Config SD'de APP_LOG_SMP_CFG_FILE (boot'ta okunur), satir basina bir kanal:
+ *   rate_hz,addr[:deadband],addr[:deadband],...      orn: 100,6,7,8:5,9:0
+ * Gecersiz rate, bank disi register, fazla kanal ya da taninmayan karakter iceren
+ * satirlar stats'ta smp_rejects olarak sayilir (kanal kismen uygulanmis olabilir).
+ *
+ * SMP dosyasi (little-endian), [header, record...] segmentleri; her acilista header:
+ *  header: "MBS1", u16 header_len, u8 ch_count, u8 word_order,
+ *          kanal basina: u8 n, u8 flags (bit0: deadband), u16 period_ms, u16 addr[n],
+ *          u16 crc16
+ *  record: u8 ch, u8 n, u32 tick_ms, u16 value[n], u16 crc16
+ */
+_Static_assert((APP_P10_SCAN_IRQ_HZ % APP_LOG_SMP_TICK_HZ) == 0u, "sampler tick TIM7 frekansini tam bolmeli");
+_Static_assert(APP_LOG_SMP_CHANNELS <= 255u, "kanal no u8");
+
+#define LOG_SMP_FLAG   0x0001u /* log task: sampler tick (APP_REGS_NOTIFY_FLAG'den farkli) */
+#define LOG_SMP_DIV    (APP_P10_SCAN_IRQ_HZ / APP_LOG_SMP_TICK_HZ)
+#define LOG_SMP_NO_DB  0xFFFFu /* tetik degil */
+#define LOG_SMP_MAGIC  "MBS1"
+
+typedef struct {
+  uint32_t next;                  /* sonraki ornek tick'i */
+  uint16_t period;                /* sampler tick */
+  uint8_t  n;
+  uint8_t  has_db;
+  uint8_t  logged;                /* ilk ornek her zaman yazilir */
+  uint32_t sgn;                   /* bit i: I16, deadband isaretli */
+  uint8_t  addr[LOG_SLOT_WORDS];
+  uint16_t db[LOG_SLOT_WORDS];
+  uint16_t last[LOG_SLOT_WORDS];  /* son yazilan degerler */
+} log_smp_ch_t;
+
+static log_smp_ch_t s_ch[APP_LOG_SMP_CHANNELS];
+static uint8_t s_ch_count = 0;
+
+static volatile uint32_t s_smp_tick = 0; /* ISR */
+static uint32_t s_smp_done = 0;          /* log task: son islenen tick */
+static uint32_t s_smp_date = 0;          /* deadband referansinin gunu (yeni dosya = tam ornek) */
+static osThreadId_t volatile s_log_task = NULL;
+
+static uint32_t parse_u(const char **pp)
+{
+  const char *p = *pp;
+  uint32_t v = 0;
+  while (*p == ' ') ++p;
+  while (*p >= '0' && *p <= '9') {
+    if (v < 100000u) v = v * 10u + (uint32_t)(*p - '0');
+    ++p;
+  }
+  *pp = p;
+  return v;
+}
+
+static void smp_load(void)
+{
+  FIL f;
+  if (f_open(&f, APP_LOG_SMP_CFG_FILE, FA_READ) != FR_OK) return;
+
+  char line[160];
+  while (f_gets(line, sizeof(line), &f) != NULL) {
+    // satir buffer'a sigmadi: devami ayri satir gibi parse edilmesin
+    const size_t len = strlen(line);
+    if (len > 0u && line[len - 1u] != '\n' && !f_eof(&f)) {
+      g_stats.smp_rejects++;
+      while (f_gets(line, sizeof(line), &f) != NULL && line[strlen(line) - 1u] != '\n') { }
+      continue;
+    }
+
+    const char *p = line;
+    if (*p < '0' || *p > '9') continue; // yorum / bos satir
+    if (s_ch_count >= APP_LOG_SMP_CHANNELS) {
+      g_stats.smp_rejects++; // APP_LOG_SMP_CHANNELS doldu
+      continue;
+    }
+
+    const uint32_t rate = parse_u(&p);
+    if (rate == 0u || rate > APP_LOG_SMP_TICK_HZ) {
+      g_stats.smp_rejects++;
+      continue;
+    }
+
+    log_smp_ch_t *c = &s_ch[s_ch_count];
+    memset(c, 0, sizeof(*c));
+    c->period = (uint16_t)(APP_LOG_SMP_TICK_HZ / rate);
+
+    bool bad = false; // register atlandi: kanal eksik uygulandi
+    while (*p == ',') {
+      ++p;
+      const uint32_t a = parse_u(&p);
+      uint16_t db = LOG_SMP_NO_DB;
+      if (*p == ':') {
+        ++p;
+        const uint32_t v = parse_u(&p);
+        db = (uint16_t)((v < LOG_SMP_NO_DB) ? v : (LOG_SMP_NO_DB - 1u));
+      }
+      if (a >= APP_MODBUS_HR_COUNT || c->n >= LOG_SLOT_WORDS) {
+        bad = true;
+        continue;
+      }
+      if (db != LOG_SMP_NO_DB) c->has_db = 1;
+
+      const app_regs_meta_t *m = APP_RegsMetaGet((uint16_t)a);
+      if (m && m->type == APP_REGS_T_I16) c->sgn |= (1u << c->n);
+      c->addr[c->n] = (uint8_t)a;
+      c->db[c->n] = db;
+      c->n++;
+    }
+    while (*p == ' ') ++p;
+    if (*p != '\0' && *p != '\r' && *p != '\n') bad = true; // taninmayan karakter, kalan satir atlandi
+
+    if (c->n > 0) s_ch_count++;
+    if (bad || c->n == 0) g_stats.smp_rejects++;
+  }
+  (void)f_close(&f);
+}
+
+static bool smp_triggered(log_smp_ch_t *c, const uint16_t *v)
+{
+  if (!c->has_db || !c->logged) return true;
+
+  for (uint8_t i = 0; i < c->n; ++i) {
+    if (c->db[i] == LOG_SMP_NO_DB) continue;
+    const int32_t diff = ((c->sgn >> i) & 1u) ? (int32_t)(int16_t)v[i] - (int32_t)(int16_t)c->last[i]
+                                               : (int32_t)v[i] - (int32_t)c->last[i];
+    if ((uint32_t)(diff < 0 ? -diff : diff) > c->db[i]) return true;
+  }
+  return false;
+}
+
+static void write_smp_header(log_stream_t *st)
+{
+  uint8_t h[8u + APP_LOG_SMP_CHANNELS * (4u + 2u * LOG_SLOT_WORDS) + 2u];
+
+  memcpy(h, LOG_SMP_MAGIC, 4);
+  uint8_t *p = &h[8];
+  for (uint8_t k = 0; k < s_ch_count; ++k) {
+    const log_smp_ch_t *c = &s_ch[k];
+    *p++ = c->n;
+    *p++ = c->has_db;
+    p = put16(p, (uint16_t)((1000u * c->period) / APP_LOG_SMP_TICK_HZ));
+    for (uint8_t i = 0; i < c->n; ++i) p = put16(p, c->addr[i]);
+  }
+  const uint16_t len = (uint16_t)(p - h + 2);
+  (void)put16(&h[4], len);
+  h[6] = s_ch_count;
+  h[7] = APP_RegsMainMap()->word_order;
+  (void)put16(p, crc16(h, (uint32_t)(p - h)));
+
+  (void)log_write(st, h, len);
+}
+
+#endif /* APP_LOG_SMP_ENABLE */
+
+static void write_regmap(void)
+{
+  // register map (APP_HR_TABLE) -> logs/REGMAP.CSV, SCADA import icin; her boot'ta guncellenir
+  uint32_t len = 0;
+  const char *csv = APP_RegsMetaCsv(&len);
+
+  FIL f;
+  if (f_open(&f, APP_LOG_DIR "/REGMAP.CSV", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) return;
+  UINT bw = 0;
+  (void)f_write(&f, csv, (UINT)len, &bw);
+  (void)bw;
+  (void)f_close(&f);
+}
+
+static bool open_daily_file(log_stream_t *st, uint16_t y, uint8_t m, uint8_t d)
+{
+  if (st->open && st->open_y == y && st->open_m == m && st->open_d == d) {
     return true;
   }
 
-  close_file();
+  close_file(st, true); // baska gunun dosyasi acikti
 
   ensure_log_dir();
 
-  char path[64];
-  snprintf(path, sizeof(path), "%s/%04u-%02u-%02u.csv", APP_LOG_DIR, (unsigned)y, (unsigned)m, (unsigned)d);
+  char path[32];
+  log_path(path, sizeof(path), y, m, d, st->ext);
 
-  FRESULT fr = f_open(&g_file, path, FA_OPEN_ALWAYS | FA_WRITE);
+#if APP_LOG_PREALLOC_BYTES
+  if (st->prealloc != 0 && f_stat(path, NULL) == FR_NO_FILE) seg_trim_stale(st, y, m, d);
+#endif
+
+  FRESULT fr = f_open(&st->file, path, FA_OPEN_ALWAYS | FA_WRITE);
   if (fr != FR_OK) {
     return false;
   }
-  // append mode
-  (void)f_lseek(&g_file, f_size(&g_file));
+  const FSIZE_t size = f_size(&st->file);
+#if APP_LOG_PREALLOC_BYTES
+  if (!seg_attach(st))
+#endif
+  {
+    // append mode
+    (void)f_lseek(&st->file, size);
+  }
 
-  // header (only if new/empty file)
-  if (f_size(&g_file) == 0) {
-#if (APP_LOG_PAYLOAD_COUNT_HR == 10) && (APP_LOG_PAYLOAD_START_HR == 6)
-    static const char hdr[] = "tick_ms,minutes,seconds,hr6,hr7,hr8,hr9,hr10,hr11,hr12,hr13,hr14,hr15\r\n";
+#if APP_LOG_SMP_ENABLE
+  if (st == &s_st[LOG_STREAM_SMP]) {
+    write_smp_header(st);
+    log_sync(st);
+  } else
+#endif
+  {
+#if APP_LOG_FORMAT == APP_LOG_FORMAT_BIN
+    // her acilista yeni segment header'i
+    write_bin_header(st);
+    log_sync(st);
 #else
-    // generic header
-    char hdr[256];
-    int n = snprintf(hdr, sizeof(hdr), "tick_ms,minutes,seconds");
-    for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) {
-      n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, ",hr%u", (unsigned)(APP_LOG_PAYLOAD_START_HR + i));
+    // header (only if new/empty file)
+    if (size == 0) {
+      write_csv_header(st);
+      log_sync(st);
     }
-    n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, "\r\n");
 #endif
-    UINT bw = 0;
-#if (APP_LOG_PAYLOAD_COUNT_HR == 10) && (APP_LOG_PAYLOAD_START_HR == 6)
-    (void)f_write(&g_file, hdr, sizeof(hdr) - 1, &bw);
+  }
+
+  st->open = 1;
+  st->open_y = y; st->open_m = m; st->open_d = d;
+  return true;
+}
+
+/* SD islem suresi (DWT cycle -> us) */
+static void stats_latency(uint32_t t0)
+{
+  const uint32_t us = (DWT->CYCCNT - t0) / (SystemCoreClock / 1000000u);
+  g_stats.write_last_us = us;
+  if (us > g_stats.write_max_us) g_stats.write_max_us = us;
+}
+
+/* ------------------ sample ring (log task -> writer) ------------------ */
+
+/*
+ * Log task yalnizca snapshot alip ring'e koyar (formatlama yok). Ring CCMRAM'de
+ * APP_LOG_RING_SLOTS ham kayit tutar: SD erase / f_sync takilmalari (yuzlerce ms)
+ * bu surede record kaybettirmez.
+ *
+ * Tek uretici / tek tuketici, lock-free: head'i yalnizca log task, tail'i writer
+ * ilerletir. DROP_OLDEST'te uretici de tail'i CAS ile bir ilerletir; tuketici slotu
+ * kopyalayip tail'i CAS ile alir, CAS kaybederse (slot dusuruldu / uzerine yazildi)
+ * kopyayi atar.
+ *
+ * Writer record'lari formatlayip akisin hizali SRAM staging buffer'ina dizer; buffer
+ * sektor sinirinda dolunca tek f_write / seg_write ile tam sektorler gider. f_sync
+ * yalnizca APP_LOG_FLUSH_MAX_AGE_MS'de bir, gun degisiminde ya da log kapanirken calisir.
+ */
+_Static_assert((APP_LOG_BUF_SIZE % 512u) == 0u && APP_LOG_BUF_SIZE >= 1024u && APP_LOG_BUF_SIZE <= 32768u,
+               "APP_LOG_BUF_SIZE 512'nin kati olmali");
+_Static_assert((APP_LOG_RING_SLOTS & (APP_LOG_RING_SLOTS - 1u)) == 0u, "APP_LOG_RING_SLOTS 2'nin kuvveti olmali");
+
+#define LOG_WR_FLAG     0x0001u
+#define LOG_RING_MASK   (APP_LOG_RING_SLOTS - 1u)
+
+#define LOG_SLOT_ROW    0u /* MMM/SS satiri */
+#define LOG_SLOT_CLOSE  1u /* log kapandi: staging + sync + close */
+#define LOG_SLOT_SMP    2u /* sampler kanal ornegi */
+
+typedef struct {
+  uint32_t tick_ms;
+  uint8_t  kind;                 /* LOG_SLOT_* */
+  uint8_t  ch;                   /* SMP: kanal */
+  uint8_t  n;                    /* SMP: word sayisi */
+  uint8_t  rsv;
+  uint16_t y;
+  uint8_t  m;
+  uint8_t  d;
+  uint16_t w[LOG_SLOT_WORDS];    /* ROW: HR0.. snapshot, SMP: kanal register'lari */
+} log_slot_t;
+
+static log_slot_t s_ring[APP_LOG_RING_SLOTS] __attribute__((section(".ccmram_noinit")));
+static uint32_t s_head = 0;        /* log task yazar */
+static uint32_t s_tail = 0;        /* writer (DROP_OLDEST: log task da CAS ile) */
+static uint32_t s_ring_drops = 0;
+static uint32_t s_ring_hwm = 0;
+static uint32_t s_drop_last_ms = 0;
+static uint32_t s_drop_write = 0;  /* f_write / f_open hatasi */
+static osThreadId_t s_writer = NULL;
+
+static void ring_drop(void)
+{
+  s_ring_drops++;
+  s_drop_last_ms = HAL_GetTick();
+}
+
+/*
+ * Ring doluyken (APP_LOG_RING_POLICY):
+ *  DROP_NEWEST: yeni kayit dusurulur (dosyada eski kayitlar kesintisiz kalir)
+ *  DROP_OLDEST: en eski kayit dusurulur (en guncel veri korunur)
+ *  BLOCK      : log task APP_LOG_RING_BLOCK_MS'e kadar bekler, sonra DROP_NEWEST
+ * Her dusen kayit ring_drops'a sayilir, son kaybin zamani drop_last_ms.
+ */
+static bool ring_push(const log_slot_t *src)
+{
+  const uint32_t h = s_head;
+  uint32_t t = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+
+  if (h - t >= APP_LOG_RING_SLOTS) {
+#if APP_LOG_RING_POLICY == APP_LOG_RING_DROP_OLDEST
+    // CAS'i kaybedersek writer zaten yer acti
+    if (__atomic_compare_exchange_n(&s_tail, &t, t + 1u, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) ring_drop();
+#elif APP_LOG_RING_POLICY == APP_LOG_RING_BLOCK
+    const uint32_t t0 = HAL_GetTick();
+    while (h - t >= APP_LOG_RING_SLOTS) {
+      if ((HAL_GetTick() - t0) >= APP_LOG_RING_BLOCK_MS) {
+        ring_drop();
+        return false;
+      }
+      if (s_writer != NULL) (void)osThreadFlagsSet(s_writer, LOG_WR_FLAG);
+      osDelay(1);
+      t = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    }
 #else
-    (void)f_write(&g_file, hdr, (UINT)strlen(hdr), &bw);
+    ring_drop();
+    return false;
 #endif
-    (void)bw;
-    (void)f_sync(&g_file);
   }
 
-  g_file_open = 1;
-  g_open_y = y; g_open_m = m; g_open_d = d;
+  log_slot_t *e = &s_ring[h & LOG_RING_MASK];
+  memcpy(e, src, offsetof(log_slot_t, w) + (size_t)src->n * sizeof(uint16_t));
+  __atomic_store_n(&s_head, h + 1u, __ATOMIC_RELEASE);
+
+  const uint32_t depth = h + 1u - __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+  if (depth > s_ring_hwm) s_ring_hwm = depth;
+  if (s_writer != NULL) (void)osThreadFlagsSet(s_writer, LOG_WR_FLAG);
   return true;
 }
 
+static bool ring_pop(log_slot_t *out)
+{
+  for (;;) {
+    uint32_t t = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&s_head, __ATOMIC_ACQUIRE) == t) return false;
+
+    *out = s_ring[t & LOG_RING_MASK];
+    if (__atomic_compare_exchange_n(&s_tail, &t, t + 1u, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return true;
+    // DROP_OLDEST: uretici bu kaydi dusurdu, kopya yirtik olabilir
+  }
+}
+
+/* ------------------ writer staging ------------------ */
+
+static void stage_flush(log_stream_t *st)
+{
+  if (st->stage_len == 0) return;
+
+  const uint32_t t0 = DWT->CYCCNT;
+  const FRESULT fr = log_write(st, st->stage, (UINT)st->stage_len);
+  stats_latency(t0);
+  g_stats.flushes++;
+  if (fr == FR_OK) g_stats.lines += st->stage_recs;
+  else s_drop_write += st->stage_recs;
+
+  st->stage_len = 0;
+  st->stage_recs = 0;
+}
+
+/* Record sektor sinirinda bolunebilir: dolan staging hemen yazilir.
+ * Bos staging'in ilk dolumu dosya pozisyonunu sektor sinirina tamamlar. */
+static void stage_append(log_stream_t *st, const uint8_t *p, uint32_t len)
+{
+  if (st->stage_len == 0) st->stage_limit = APP_LOG_BUF_SIZE - (uint32_t)(log_tell(st) % 512u);
+  st->stage_recs++;
+
+  while (len > 0) {
+    uint32_t n = st->stage_limit - st->stage_len;
+    if (n > len) n = len;
+    memcpy(&st->stage[st->stage_len], p, n);
+    st->stage_len += n;
+    p += n;
+    len -= n;
+    if (st->stage_len == st->stage_limit) {
+      stage_flush(st);
+      st->stage_limit = APP_LOG_BUF_SIZE;
+    }
+  }
+
+  if (!st->unsynced) {
+    st->unsynced = 1;
+    st->unsynced_t0 = HAL_GetTick();
+  }
+}
+
+static void writer_sync(log_stream_t *st)
+{
+  stage_flush(st);
+  st->unsynced = 0;
+  if (!st->open) return;
+  const uint32_t t0 = DWT->CYCCNT;
+  log_sync(st);
+  stats_latency(t0);
+  g_stats.syncs++;
+}
+
+static void writer_slot(const log_slot_t *e)
+{
+#if APP_LOG_SMP_ENABLE
+  log_stream_t *st = &s_st[(e->kind == LOG_SLOT_SMP) ? LOG_STREAM_SMP : LOG_STREAM_ROW];
+#else
+  log_stream_t *st = &s_st[LOG_STREAM_ROW];
+#endif
+
+  if (st->open && (e->y != st->open_y || e->m != st->open_m || e->d != st->open_d)) {
+    writer_sync(st);
+    close_file(st, true); // gun bitti
+  }
+  bool ok = g_fs_mounted && st->open;
+  if (g_fs_mounted && !st->open) {
+    // gun dosyasi acilisi da SD islemi: f_expand on-tahsisin FAT zincirini yazar (64 MB ~256 sektor)
+    const uint32_t t0 = DWT->CYCCNT;
+    ok = open_daily_file(st, e->y, e->m, e->d);
+    stats_latency(t0);
+  }
+  if (!ok) {
+    s_drop_write++;
+    return;
+  }
+
+#if APP_LOG_SMP_ENABLE
+  if (e->kind == LOG_SLOT_SMP) {
+    uint8_t rec[6u + 2u * LOG_SLOT_WORDS + 2u];
+    uint8_t *p = rec;
+    *p++ = e->ch;
+    *p++ = e->n;
+    p = put32(p, e->tick_ms);
+    for (uint8_t i = 0; i < e->n; ++i) p = put16(p, e->w[i]);
+    p = put16(p, crc16(rec, (uint32_t)(p - rec)));
+    stage_append(st, rec, (uint32_t)(p - rec));
+    return;
+  }
+#endif
+
+#if APP_LOG_FORMAT == APP_LOG_FORMAT_BIN
+  uint8_t line[LOG_BIN_REC_LEN];
+  const UINT len = fmt_bin_record(line, e->tick_ms, e->w);
+#else
+  char line[256];
+  const UINT len = fmt_csv_record(line, sizeof(line), e->tick_ms, e->w);
+#endif
+  stage_append(st, (const uint8_t *)line, len);
+}
+
+/* ------------------ sampler (log task) ------------------ */
+
+#if APP_LOG_SMP_ENABLE
+static void smp_run(uint32_t tick_ms, bool run)
+{
+  const uint32_t now = s_smp_tick;
+  if (now == s_smp_done) return;
+  if (run && (now - s_smp_done) > 1u) g_stats.smp_late += now - s_smp_done - 1u; // log task gecikti
+  s_smp_done = now;
+  if (!run) {
+    s_smp_date = 0; // yeniden acilan dosya deadband referansini tekrar yazsin
+    return;
+  }
+
+  uint16_t hr[APP_MODBUS_HR_COUNT];
+  bool have = false;
+
+  for (uint8_t k = 0; k < s_ch_count; ++k) {
+    log_smp_ch_t *c = &s_ch[k];
+    if ((int32_t)(now - c->next) < 0) continue;
+    c->next += c->period;
+    if ((int32_t)(now - c->next) >= 0) c->next = now + c->period;
+
+    if (!have) {
+      (void)APP_RegsReadHRBlock(0, hr, APP_MODBUS_HR_COUNT);
+      have = true;
+
+      const uint32_t date = ((uint32_t)hr[APP_HR_YEAR] << 16) | ((uint32_t)hr[APP_HR_MONTH] << 8) | hr[APP_HR_DAY];
+      if (date != s_smp_date) {
+        s_smp_date = date;
+        for (uint8_t j = 0; j < s_ch_count; ++j) s_ch[j].logged = 0;
+      }
+    }
+
+    log_slot_t e;
+    e.kind = LOG_SLOT_SMP;
+    e.ch = k;
+    e.n = c->n;
+    e.rsv = 0;
+    e.tick_ms = tick_ms;
+    e.y = hr[APP_HR_YEAR];
+    e.m = (uint8_t)hr[APP_HR_MONTH];
+    e.d = (uint8_t)hr[APP_HR_DAY];
+    for (uint8_t i = 0; i < c->n; ++i) e.w[i] = hr[c->addr[i]];
+
+    if (!smp_triggered(c, e.w)) continue;
+    if (!date_valid(e.y, e.m, e.d)) continue;
+    if (ring_push(&e)) {
+      memcpy(c->last, e.w, (size_t)c->n * sizeof(uint16_t));
+      c->logged = 1;
+    }
+  }
+}
+#endif
+
+/* ------------------ public ------------------ */
+
+void APP_LogGetStats(app_log_stats_t *out)
+{
+  if (!out) return;
+  *out = g_stats;
+  out->ring_drops = s_ring_drops;
+  out->ring_hwm = s_ring_hwm;
+  out->ring_depth = __atomic_load_n(&s_head, __ATOMIC_RELAXED) - __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+  out->drop_last_ms = s_drop_last_ms;
+  out->drops = s_ring_drops + s_drop_write;
+}
+
+int32_t APP_LogReadAt(uint16_t y, uint8_t m, uint8_t d, uint32_t offset, void *buf, uint32_t len)
+{
+  static FIL f;
+  if (!g_fs_mounted || !buf) return -1;
+
+  char path[32];
+  log_path(path, sizeof(path), y, m, d, s_st[LOG_STREAM_ROW].ext);
+  if (f_open(&f, path, FA_READ) != FR_OK) return -1;
+
+  // fast seek: on-tahsisli dosya tek fragment (4 word); parcaliysa 3 fragment'e kadar
+  DWORD tbl[8] = { 8u };
+  f.cltbl = tbl;
+  if (f_lseek(&f, CREATE_LINKMAP) != FR_OK) f.cltbl = NULL;
+
+  UINT br = 0;
+  FRESULT fr = f_lseek(&f, offset);
+  if (fr == FR_OK) fr = f_read(&f, buf, (UINT)len, &br);
+  (void)f_close(&f);
+  return (fr == FR_OK) ? (int32_t)br : -1;
+}
+
 void APP_LogInit(void)
 {
-  g_log_q = osMessageQueueNew(8, sizeof(log_evt_t), NULL);
+#if APP_LOG_FORMAT == APP_LOG_FORMAT_BIN
+  s_st[LOG_STREAM_ROW].ext = "BIN";
+#else
+  s_st[LOG_STREAM_ROW].ext = "CSV";
+#endif
+  s_st[LOG_STREAM_ROW].prealloc = APP_LOG_PREALLOC_BYTES;
+#if APP_LOG_SMP_ENABLE
+  s_st[LOG_STREAM_SMP].ext = "SMP";
+  s_st[LOG_STREAM_SMP].prealloc = APP_LOG_PREALLOC_BYTES ? APP_LOG_SMP_PREALLOC_BYTES : 0u;
+#endif
 
   // mount once
   if (f_mount(&g_fs, "", 1) == FR_OK) {
     g_fs_mounted = 1;
     ensure_log_dir();
+    write_regmap();
+#if APP_LOG_SMP_ENABLE
+    smp_load();
+#endif
   } else {
     g_fs_mounted = 0;
   }
 }
 
-void APP_LogNotifyTime(uint16_t minutes, uint16_t seconds)
+/* TIM7 ISR'inden (APP_P10_SCAN_IRQ_HZ); APP_LOG_SMP_TICK_HZ'e bolunur */
+void APP_LogSamplerTickISR(void)
 {
-  if (!g_log_q) return;
-  log_evt_t e;
-  e.tick_ms = (uint32_t)HAL_GetTick();
-  e.minutes = minutes;
-  e.seconds = seconds;
-  (void)osMessageQueuePut(g_log_q, &e, 0, 0);
+#if APP_LOG_SMP_ENABLE
+  static uint16_t div = 0;
+  if (++div < LOG_SMP_DIV) return;
+  div = 0;
+
+  s_smp_tick++;
+  if (s_ch_count > 0 && s_log_task != NULL) (void)osThreadFlagsSet(s_log_task, LOG_SMP_FLAG);
+#endif
 }
 
 void APP_LogTask(void *argument)
 {
   (void)argument;
 
-  uint32_t last_sync = HAL_GetTick();
+  uint8_t active = 0; // writer'a CLOSE'suz kayit gitti
+
+#if APP_LOG_SMP_ENABLE
+  s_smp_done = s_smp_tick;
+  s_log_task = osThreadGetId();
+  const uint32_t wait_flags = APP_REGS_NOTIFY_FLAG | LOG_SMP_FLAG;
+#else
+  const uint32_t wait_flags = APP_REGS_NOTIFY_FLAG;
+#endif
+
+  // MMM/SS (TIME hook) degisince app_regs uyandirir; her degisiklik bir satir
+  const int8_t sub = APP_RegsSubscribeHook(APP_REGS_NOTIFY_FLAG, APP_REGS_HOOK_TIME);
 
   for (;;) {
     APP_SupervisorKick(APP_KICK_LOG);
@@ -140,41 +1099,75 @@ void APP_LogTask(void *argument)
 
     const bool valid = date_valid(y, (uint8_t)mo, (uint8_t)d);
     const bool enabled = (APP_RegsGetLogEnable() != 0);
+    const bool run = g_fs_mounted && valid && enabled;
 
-    if (!g_fs_mounted || !valid || !enabled) {
-      close_file();
-    } else {
-      (void)open_daily_file(y, (uint8_t)mo, (uint8_t)d);
+    // log kapandi: bekleyen record'lar yazilip dosyalar kapanir (gun degisimini writer gorur)
+    if (active && !run) {
+      log_slot_t e;
+      memset(&e, 0, offsetof(log_slot_t, w));
+      e.kind = LOG_SLOT_CLOSE;
+      if (ring_push(&e)) active = 0;
     }
 
-    // consume log event (non-busy)
-    log_evt_t e;
-    osStatus_t st = osMessageQueueGet(g_log_q, &e, NULL, APP_LOG_SAMPLE_PERIOD_MS);
-    if (st == osOK && g_file_open) {
-      uint16_t payload[APP_LOG_PAYLOAD_COUNT_HR];
-      memset(payload, 0, sizeof(payload));
-      (void)APP_RegsReadHRBlock(APP_LOG_PAYLOAD_START_HR, payload, APP_LOG_PAYLOAD_COUNT_HR);
-
-      char line[256];
-      int n = snprintf(line, sizeof(line), "%lu,%u,%u",
-                       (unsigned long)e.tick_ms,
-                       (unsigned)e.minutes,
-                       (unsigned)e.seconds);
-      for (uint16_t i = 0; i < APP_LOG_PAYLOAD_COUNT_HR; ++i) {
-        n += snprintf(line + n, sizeof(line) - (size_t)n, ",%u", (unsigned)payload[i]);
+    // wait for time change / sampler tick (non-busy)
+    (void)osThreadFlagsWait(wait_flags, osFlagsWaitAny, APP_LOG_SAMPLE_PERIOD_MS);
+    const uint32_t tick_ms = (uint32_t)HAL_GetTick();
+
+#if APP_LOG_SMP_ENABLE
+    smp_run(tick_ms, run);
+    if (run && s_ch_count > 0) active = 1;
+#endif
+
+    if (APP_RegsTakeChanges(sub, NULL) && run) {
+      log_slot_t e;
+      e.kind = LOG_SLOT_ROW;
+      e.ch = 0;
+      e.n = LOG_SNAP_COUNT;
+      e.rsv = 0;
+      e.tick_ms = tick_ms;
+      memset(e.w, 0, sizeof(e.w));
+      (void)APP_RegsReadHRBlock(0, e.w, LOG_SNAP_COUNT);
+      e.y = e.w[APP_HR_YEAR];
+      e.m = (uint8_t)e.w[APP_HR_MONTH];
+      e.d = (uint8_t)e.w[APP_HR_DAY];
+
+      if (date_valid(e.y, e.m, e.d)) {
+        (void)ring_push(&e);
+        active = 1;
       }
-      n += snprintf(line + n, sizeof(line) - (size_t)n, "\r\n");
+    }
+  }
+}
+
+void APP_LogWriterTask(void *argument)
+{
+  (void)argument;
+
+  s_writer = osThreadGetId();
 
-      UINT bw = 0;
-      (void)f_write(&g_file, line, (UINT)strlen(line), &bw);
-      (void)bw;
+  for (;;) {
+    APP_SupervisorKick(APP_KICK_LOGWR);
+
+    // timeout: durability window'u ring bosken de isletir
+    (void)osThreadFlagsWait(LOG_WR_FLAG, osFlagsWaitAny, APP_LOG_SAMPLE_PERIOD_MS);
+
+    log_slot_t e;
+    while (ring_pop(&e)) {
+      APP_SupervisorKick(APP_KICK_LOGWR); // stall sonrasi uzun bosaltma da ilerleme
+      if (e.kind == LOG_SLOT_CLOSE) {
+        for (uint8_t i = 0; i < LOG_STREAM_COUNT; ++i) {
+          writer_sync(&s_st[i]);
+          close_file(&s_st[i], false);
+        }
+      } else {
+        writer_slot(&e);
+      }
     }
 
-    // periodic sync
-    uint32_t now = HAL_GetTick();
-    if (g_file_open && (now - last_sync) >= APP_LOG_SYNC_PERIOD_MS) {
-      (void)f_sync(&g_file);
-      last_sync = now;
+    const uint32_t now = HAL_GetTick();
+    for (uint8_t i = 0; i < LOG_STREAM_COUNT; ++i) {
+      log_stream_t *st = &s_st[i];
+      if (st->unsynced && (now - st->unsynced_t0) >= APP_LOG_FLUSH_MAX_AGE_MS) writer_sync(st);
     }
   }
 }
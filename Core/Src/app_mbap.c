@@ -0,0 +1,109 @@
+#include "app_mbap.h"
+
+#include <string.h>
+
+static uint16_t be16_rd(const uint8_t *p)
+{
+  return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+}
+
+/* PID=0 ve 2 <= LEN <= 253 (UID + max PDU) */
+static int hdr_plausible(const uint8_t *h)
+{
+  const uint16_t pid  = be16_rd(&h[2]);
+  const uint16_t mlen = be16_rd(&h[4]);
+  return (pid == 0 && mlen >= 2 && mlen <= 253);
+}
+
+static uint16_t adu_len_of(const uint8_t *h)
+{
+  return (uint16_t)(6u + be16_rd(&h[4]));
+}
+
+static size_t stash_fill(app_mbap_rx_t *rx, const uint8_t *src, size_t avail, uint16_t want)
+{
+  size_t n = (size_t)(want - rx->have);
+  if (n > avail) n = avail;
+  memcpy(&rx->stash[rx->have], src, n);
+  rx->have = (uint16_t)(rx->have + n);
+  rx->copied_bytes += (uint32_t)n;
+  return n;
+}
+
+uint16_t APP_MbapFrameLen(const uint8_t *h)
+{
+  return hdr_plausible(h) ? adu_len_of(h) : 0;
+}
+
+void APP_MbapReset(app_mbap_rx_t *rx)
+{
+  memset(rx, 0, sizeof(*rx));
+}
+
+size_t APP_MbapFeed(app_mbap_rx_t *rx, const uint8_t *data, size_t len,
+                    app_mbap_adu_fn fn, void *ctx)
+{
+  size_t off = 0;
+
+  while (off < len) {
+    /* 1) onceki parcadan kalan (bolunmus) ADU'yu tamamla */
+    if (rx->have > 0) {
+      if (rx->have < APP_MBAP_HDR_LEN) {
+        off += stash_fill(rx, data + off, len - off, APP_MBAP_HDR_LEN);
+        if (rx->have < APP_MBAP_HDR_LEN) break;
+      }
+
+      if (!hdr_plausible(rx->stash)) {
+        /* bir byte kaydir, sonraki olasi header'i ara (sadece <=7 byte) */
+        memmove(rx->stash, rx->stash + 1, (size_t)(rx->have - 1u));
+        rx->have--;
+        rx->resync_bytes++;
+        continue;
+      }
+
+      const uint16_t need = adu_len_of(rx->stash);
+      const size_t n = stash_fill(rx, data + off, len - off, need);
+      if (rx->have < need) {
+        off += n;
+        break;
+      }
+
+      if (!fn(ctx, rx->stash, need)) {
+        /* geri al: stash'te tamamlanmis ADU beklemez, kalan byte'lar tekrar gelir */
+        rx->have = (uint16_t)(rx->have - n);
+        rx->copied_bytes -= (uint32_t)n;
+        break;
+      }
+      off += n;
+      rx->adu_count++;
+      rx->have = 0;
+      continue;
+    }
+
+    /* 2) hizli yol: ADU'lar segment icinde yerinde parse edilir */
+    const uint8_t *p = data + off;
+    const size_t rem = len - off;
+
+    if (rem < APP_MBAP_HDR_LEN) {
+      off += stash_fill(rx, p, rem, APP_MBAP_HDR_LEN);
+      break;
+    }
+
+    if (!hdr_plausible(p)) {
+      off++;
+      rx->resync_bytes++;
+      continue;
+    }
+
+    const uint16_t adu_len = adu_len_of(p);
+    if (rem < adu_len) {
+      off += stash_fill(rx, p, rem, adu_len);
+      break;
+    }
+
+    if (!fn(ctx, p, adu_len)) break;
+    rx->adu_count++;
+    off += adu_len;
+  }
+  return off;
+}
@@ -0,0 +1,270 @@
+#include "app_metrics.h"
+#include "app_config.h"
+#include "app_regs.h"
+#include "app_modbus.h"
+#include "app_log.h"
+#include "app_retain.h"
+
+#include "cmsis_os.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+#include "stm32f4xx_hal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* ------------------ FreeRTOS run-time stats (DWT cycle counter) ------------------ */
+
+/* 32-bit sayac 168 MHz'de ~25.6 s'de sarar. FreeRTOS her task gecisinde delta ekler;
+ * supervisor 250 ms'de bir uyandigi icin gecis araligi wrap suresinin cok altinda kalir.
+ * Mutlak deger anlamsiz: CPU yuku APP_MetricsSample'in periyodik delta'sindan hesaplanir. */
+void configureTimerForRunTimeStats(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return DWT->CYCCNT;
+}
+
+#if APP_METRICS_ENABLE
+
+/* ------------------ getters ------------------ */
+
+typedef uint32_t (*metric_fn)(uintptr_t arg);
+
+typedef struct {
+  uint8_t   words; /* 1 ya da 2 */
+  metric_fn get;
+  uintptr_t arg;
+} metric_t;
+
+#define METRICS_VERSION 7u
+
+static uint16_t s_words;
+
+/* APP_MetricsSample (supervisor) yazar, getter'lar okur: tek 32-bit store, lock yok */
+static uint32_t s_uptime_s;
+static uint32_t s_uptime_rem_ms;
+static uint32_t s_last_tick;
+static uint32_t s_last_idle;
+static uint32_t s_last_total;
+static uint32_t s_cpu_permil;
+
+static uint32_t m_const(uintptr_t arg) { return (uint32_t)arg; }
+static uint32_t m_words(uintptr_t arg) { (void)arg; return s_words; }
+
+/* Saniye akumulatoru: 32-bit ms tick'in ~49.7 gunluk wrap'inden etkilenmez */
+static uint32_t m_uptime_s(uintptr_t arg)
+{
+  (void)arg;
+  return __atomic_load_n(&s_uptime_s, __ATOMIC_RELAXED);
+}
+
+/* Son APP_MetricsSample periyodundaki CPU yuku, permil */
+static uint32_t m_cpu_load(uintptr_t arg)
+{
+  (void)arg;
+  return __atomic_load_n(&s_cpu_permil, __ATOMIC_RELAXED);
+}
+
+static uint32_t m_heap_free(uintptr_t arg) { (void)arg; return (uint32_t)xPortGetFreeHeapSize(); }
+static uint32_t m_heap_min(uintptr_t arg)  { (void)arg; return (uint32_t)xPortGetMinimumEverFreeHeapSize(); }
+
+static uint32_t m_mb_req(uintptr_t arg)
+{
+  (void)arg;
+  uint32_t req;
+  APP_ModbusGetTotals(&req, NULL);
+  return req;
+}
+
+static uint32_t m_mb_exc(uintptr_t arg)
+{
+  (void)arg;
+  uint32_t exc;
+  APP_ModbusGetTotals(NULL, &exc);
+  return exc;
+}
+
+/* arg: app_log_stats_t alan offset'i */
+static uint32_t m_log(uintptr_t arg)
+{
+  app_log_stats_t st;
+  APP_LogGetStats(&st);
+  uint32_t v;
+  memcpy(&v, (const uint8_t *)&st + arg, sizeof(v));
+  return v;
+}
+
+/* arg: app_retain_stats_t alan offset'i (retain yoksa 0) */
+static uint32_t m_retain(uintptr_t arg)
+{
+  app_retain_stats_t st;
+  memset(&st, 0, sizeof(st));
+#if APP_RETAIN_ENABLE
+  (void)APP_RetainGetStats(&st);
+#endif
+  uint32_t v;
+  memcpy(&v, (const uint8_t *)&st + arg, sizeof(v));
+  return v;
+}
+
+/* arg: 0 = used, 1 = max (byte) */
+static uint32_t m_lwip_mem(uintptr_t arg)
+{
+#if LWIP_STATS && MEM_STATS
+  return (uint32_t)(arg ? lwip_stats.mem.max : lwip_stats.mem.used);
+#else
+  (void)arg;
+  return 0;
+#endif
+}
+
+/* arg: memp pool << 8 | 0 = used, 1 = max, 2 = avail */
+static uint32_t m_lwip_memp(uintptr_t arg)
+{
+#if LWIP_STATS && MEMP_STATS
+  const struct stats_mem *s = lwip_stats.memp[arg >> 8];
+  if (!s) return 0;
+  switch (arg & 0xFFu) {
+    case 0:  return s->used;
+    case 1:  return s->max;
+    default: return s->avail;
+  }
+#else
+  (void)arg;
+  return 0;
+#endif
+}
+
+/* arg: task adi. Word cinsinden stack high-water mark, 0xFFFF = task yok */
+static uint32_t m_stack_hwm(uintptr_t arg)
+{
+  TaskHandle_t t = xTaskGetHandle((const char *)arg);
+  return t ? (uint32_t)uxTaskGetStackHighWaterMark(t) : 0xFFFFu;
+}
+
+#define MEMP_ARG(pool, field) (((uintptr_t)(pool) << 8) | (field))
+#define LOG_ARG(field)        ((uintptr_t)offsetof(app_log_stats_t, field))
+#define RET_ARG(field)        ((uintptr_t)offsetof(app_retain_stats_t, field))
+
+/* Layout (METRICS_VERSION 7). Yeni alan sona eklenir, version artar. */
+static const metric_t s_metrics[] = {
+  { 1, m_const,     METRICS_VERSION },
+  { 1, m_words,     0 },
+  { 2, m_uptime_s,  0 },
+  { 1, m_cpu_load,  0 },
+  { 2, m_heap_free, 0 },
+  { 2, m_heap_min,  0 },
+  { 2, m_mb_req,    0 },
+  { 2, m_mb_exc,    0 },
+  { 2, m_log,       LOG_ARG(drops) },
+  { 2, m_log,       LOG_ARG(write_last_us) },
+  { 2, m_log,       LOG_ARG(write_max_us) },
+  { 2, m_lwip_mem,  0 },
+  { 2, m_lwip_mem,  1 },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_PBUF_POOL, 0) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_PBUF_POOL, 1) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_PBUF_POOL, 2) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_TCP_PCB, 0) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_TCP_PCB, 1) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_NETCONN, 0) },
+  { 1, m_lwip_memp, MEMP_ARG(MEMP_NETCONN, 1) },
+  { 1, m_stack_hwm, (uintptr_t)"modbus" },
+  { 1, m_stack_hwm, (uintptr_t)"log" },
+  { 1, m_stack_hwm, (uintptr_t)"p10" },
+  { 1, m_stack_hwm, (uintptr_t)"sup" },
+  { 1, m_stack_hwm, (uintptr_t)"retain" },
+  { 1, m_stack_hwm, (uintptr_t)"tcpip_thread" },
+  { 1, m_stack_hwm, (uintptr_t)"EthIf" },
+  { 1, m_stack_hwm, (uintptr_t)"EthLink" },
+  { 1, m_stack_hwm, (uintptr_t)"defaultTask" },
+  /* v2 */
+  { 2, m_log,       LOG_ARG(flushes) },
+  { 2, m_log,       LOG_ARG(syncs) },
+  { 1, m_stack_hwm, (uintptr_t)"logwr" },
+  /* v3 */
+  { 2, m_log,       LOG_ARG(ring_drops) },
+  { 2, m_log,       LOG_ARG(ring_hwm) },
+  { 2, m_log,       LOG_ARG(ring_depth) },
+  { 2, m_log,       LOG_ARG(drop_last_ms) },
+  /* v4 */
+  { 2, m_log,       LOG_ARG(smp_late) },
+  /* v5 */
+  { 2, m_retain,    RET_ARG(errors) },
+  { 2, m_retain,    RET_ARG(erase_max_us) },
+  /* v6 */
+  { 2, m_log,       LOG_ARG(trims) },
+  /* v7 */
+  { 2, m_log,       LOG_ARG(smp_rejects) },
+};
+
+#define METRICS_COUNT (sizeof(s_metrics) / sizeof(s_metrics[0]))
+
+/* ------------------ public ------------------ */
+
+void APP_MetricsInit(void)
+{
+  s_last_tick     = osKernelGetTickCount();
+  s_uptime_s      = s_last_tick / 1000u;
+  s_uptime_rem_ms = s_last_tick % 1000u;
+  s_last_idle     = ulTaskGetIdleRunTimeCounter();
+  s_last_total    = getRunTimeCounterValue();
+
+  s_words = 0;
+  for (uint32_t i = 0; i < METRICS_COUNT; ++i) s_words = (uint16_t)(s_words + s_metrics[i].words);
+
+  (void)APP_RegsMapAddFn(APP_RegsMainMap(), APP_REGS_IR, APP_METRICS_IR_BASE, s_words, APP_MetricsRead);
+}
+
+/* Tek cagiran (supervisor, 250 ms): delta'lar DWT wrap'inden (~25.6 s) kisa kalir */
+void APP_MetricsSample(void)
+{
+  const uint32_t tick = osKernelGetTickCount();
+  uint32_t ms = s_uptime_rem_ms + (tick - s_last_tick);
+  s_last_tick = tick;
+  __atomic_store_n(&s_uptime_s, s_uptime_s + ms / 1000u, __ATOMIC_RELAXED);
+  s_uptime_rem_ms = ms % 1000u;
+
+  const uint32_t idle  = ulTaskGetIdleRunTimeCounter();
+  const uint32_t total = getRunTimeCounterValue();
+  const uint32_t di = idle - s_last_idle;
+  const uint32_t dt = total - s_last_total;
+  s_last_idle  = idle;
+  s_last_total = total;
+
+  const uint32_t load = (dt == 0 || di >= dt) ? 0u : 1000u - (uint32_t)(((uint64_t)di * 1000u) / dt);
+  __atomic_store_n(&s_cpu_permil, load, __ATOMIC_RELAXED);
+}
+
+/* Sadece istenen araliga dusen getter'lar cagrilir (her biri bir kez) */
+uint16_t APP_MetricsRead(uint16_t off, uint16_t *out, uint16_t qty)
+{
+  if (!out || qty == 0) return 0;
+  if ((uint32_t)off + qty > s_words) return 0;
+
+  const uint16_t end = (uint16_t)(off + qty);
+  uint16_t pos = 0;
+  for (uint32_t i = 0; i < METRICS_COUNT && pos < end; ++i) {
+    const metric_t *m = &s_metrics[i];
+    if ((uint16_t)(pos + m->words) > off) {
+      const uint32_t v = m->get(m->arg);
+      for (uint8_t k = 0; k < m->words; ++k) {
+        const uint16_t a = (uint16_t)(pos + k);
+        if (a < off || a >= end) continue;
+        out[a - off] = (m->words == 2u && k == 0) ? (uint16_t)(v >> 16) : (uint16_t)v;
+      }
+    }
+    pos = (uint16_t)(pos + m->words);
+  }
+  return qty;
+}
+
+#endif /* APP_METRICS_ENABLE */
@@ -1,249 +1,319 @@
 #include "app_modbus.h"
 
-#include "app_regs.h"
-#include "app_log.h"
-#include "app_p10.h"
+#include "app_mbap.h"
+#include "app_supervisor.h"
+#include "app_config.h"
 
 #include "cmsis_os.h"
 
 #include "lwip/api.h"
 #include "lwip/err.h"
+#include "lwip/pbuf.h"
 
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
 
-/* ------------------ Unit ID ------------------ */
-
-/* ESKI: Unit ID sabit tanim yoktu, gelen UID aynen echo ediliyordu */
-#ifndef APP_MODBUS_UNIT_ID
-#define APP_MODBUS_UNIT_ID 10u
+#if (APP_MODBUS_MAX_CONN + 1u + APP_MODBUS_UDP_ENABLE) > MEMP_NUM_NETCONN || (APP_MODBUS_MAX_CONN + 1u) > MEMP_NUM_TCP_PCB
+#error "APP_MODBUS_MAX_CONN + listener lwIP netconn/tcp_pcb havuzuna sigmiyor (lwipopts.h)"
 #endif
 
-/* ------------------ helpers ------------------ */
+_Static_assert(APP_MODBUS_TX_BATCH_SIZE >= APP_MBAP_MAX_ADU, "TX batch must hold one full ADU");
+
+#if APP_MODBUS_ENGINE == APP_MODBUS_ENGINE_NETCONN
+
+/* ------------------ net events ------------------ */
 
-static uint16_t be16_rd(const uint8_t *p) {
-  return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+#define MB_FLAG_NET 0x0001u
+
+static osThreadId_t s_task = NULL;
+
+#if APP_MODBUS_EVENT_DRIVEN
+/* tcpip_thread context: accept, data ve FIN/RST hepsi RCVPLUS/ERROR olarak gelir.
+ * Accept edilen netconn'lar listener callback'ini miras alir. */
+static void mb_netconn_evt(struct netconn *conn, enum netconn_evt evt, u16_t len)
+{
+  (void)conn;
+  (void)len;
+  /* SENDPLUS: ACK ile send buffer acildi, bekleyen TX devam edebilir */
+  if ((evt == NETCONN_EVT_RCVPLUS || evt == NETCONN_EVT_SENDPLUS || evt == NETCONN_EVT_ERROR) && s_task != NULL) {
+    (void)osThreadFlagsSet(s_task, MB_FLAG_NET);
+  }
 }
-static void be16_wr(uint8_t *p, uint16_t v) {
-  p[0] = (uint8_t)(v >> 8);
-  p[1] = (uint8_t)(v & 0xFF);
+#endif
+
+/* ------------------ sessions ------------------ */
+
+/*
+ * Her istemci icin statik session; pool dolunca en uzun suredir sessiz olan atilir.
+ *
+ * Tek modbus task tum session'lari servis eder, bu yuzden hicbir cagri bloklamaz:
+ * netconn_write_partly(NETCONN_DONTBLOCK) send buffer'a sigani yazar, kalan tx'te
+ * bekler. TX dolu iken session'in pbuf'u (rx_p/rx_off) parse edilmeden tutulur ve
+ * yeni segment alinmaz; okunmayan veri TCP window'unu kapatir (backpressure).
+ * Send window'u APP_MODBUS_TX_STALL_MS boyunca hic acilmayan (olu) peer kapatilir.
+ */
+typedef struct {
+  struct netconn *conn;
+  uint32_t        last_rx_ms;
+  app_mbap_rx_t   rx;
+
+  /* parse'i TX yuzunden yarim kalan segment */
+  struct pbuf    *rx_p;
+  uint16_t        rx_off;
+
+  /* coalesced TX: bir recv batch'inin cevaplari; gonderilemeyen kisim bekler */
+  uint16_t        tx_len;
+  uint32_t        tx_stall_ms;        /* tx bekliyorsa son ilerleme */
+  uint8_t         tx[APP_MODBUS_TX_BATCH_SIZE];
+
+  uint32_t        resp_count;
+  uint32_t        tx_writes;
+  uint32_t        tx_stalls;          /* send window dolu (ERR_WOULDBLOCK / kismi yazma) */
+} mb_session_t;
+
+static mb_session_t s_sess[APP_MODBUS_MAX_CONN];
+static uint8_t      s_rr = 0; /* round-robin start index */
+
+static void session_reset(mb_session_t *ss)
+{
+  APP_MbapReset(&ss->rx);
+  ss->rx_p = NULL;
+  ss->rx_off = 0;
+  ss->tx_len = 0;
+  ss->resp_count = 0;
+  ss->tx_writes = 0;
+  ss->tx_stalls = 0;
 }
 
-/* ------------------ Modbus PDU handler ------------------ */
+static void session_close(mb_session_t *ss)
+{
+  if (ss->conn == NULL) return;
+  if (ss->rx_p != NULL) {
+    pbuf_free(ss->rx_p);
+    ss->rx_p = NULL;
+  }
+  ss->tx_len = 0;
+  APP_RegsTxnRelease((uint8_t)(ss - s_sess)); /* slot yeniden kullanilacak */
+  netconn_close(ss->conn);
+  netconn_delete(ss->conn);
+  ss->conn = NULL;
+}
 
-static int handle_pdu(const uint8_t *req_pdu, uint16_t req_len,
-                      uint8_t *resp_pdu, uint16_t resp_cap)
+/* more=1: batch devam ediyor, PSH koyma (NETCONN_MORE).
+ * Bloklamaz; send buffer'a sigmayan kisim tx'in basina kaydirilip bekler. */
+static void session_flush(mb_session_t *ss, uint8_t more)
 {
-  if (req_len < 1) return -1;
-  const uint8_t fc = req_pdu[0];
-
-  /* 0x03 Read Holding Registers */
-  if (fc == 0x03) {
-    if (req_len < 5) return -1;
-    const uint16_t addr = be16_rd(&req_pdu[1]);
-    const uint16_t qty  = be16_rd(&req_pdu[3]);
-
-    if (qty == 0 || qty > 125) {
-      resp_pdu[0] = (uint8_t)(fc | 0x80);
-      resp_pdu[1] = 0x03; /* ILLEGAL DATA VALUE */
-      return 2;
-    }
+  if (ss->tx_len == 0 || ss->conn == NULL) return;
+
+  size_t written = 0;
+  const err_t err = netconn_write_partly(ss->conn, ss->tx, ss->tx_len,
+                                         NETCONN_COPY | NETCONN_DONTBLOCK | (more ? NETCONN_MORE : 0),
+                                         &written);
+  if (err != ERR_OK && err != ERR_WOULDBLOCK) {
+    session_close(ss); /* reset/abort */
+    return;
+  }
 
-    uint16_t tmp[125];
-    const uint16_t got = APP_RegsReadHRBlock(addr, tmp, qty);
-    if (got != qty) {
-      resp_pdu[0] = (uint8_t)(fc | 0x80);
-      resp_pdu[1] = 0x02; /* ILLEGAL DATA ADDRESS */
-      return 2;
-    }
+  const uint32_t now = osKernelGetTickCount();
+  if (written > 0) {
+    ss->tx_writes++;
+    ss->tx_stall_ms = now;
+  }
+  if (written < ss->tx_len) {
+    memmove(ss->tx, &ss->tx[written], ss->tx_len - written);
+    ss->tx_stalls++;
+  }
+  ss->tx_len = (uint16_t)(ss->tx_len - written);
+}
 
-    const uint16_t bc = (uint16_t)(qty * 2);
-    if ((uint32_t)bc + 2U > resp_cap) return -1;
+static mb_session_t *session_alloc(void)
+{
+  mb_session_t *lru = &s_sess[0];
 
-    resp_pdu[0] = fc;
-    resp_pdu[1] = (uint8_t)bc;
-    for (uint16_t i = 0; i < qty; ++i) {
-      be16_wr(&resp_pdu[2 + i * 2], tmp[i]);
-    }
-    return (int)(2 + bc);
+  for (uint32_t i = 0; i < APP_MODBUS_MAX_CONN; ++i) {
+    mb_session_t *ss = &s_sess[i];
+    if (ss->conn == NULL) return ss;
+    if ((int32_t)(ss->last_rx_ms - lru->last_rx_ms) < 0) lru = ss;
   }
 
-  /* 0x06 Write Single Holding Register */
-  if (fc == 0x06) {
-    if (req_len < 5) return -1;
-    const uint16_t addr = be16_rd(&req_pdu[1]);
-    const uint16_t val  = be16_rd(&req_pdu[3]);
+  /* pool full -> evict least-recently-active client */
+  session_close(lru);
+  return lru;
+}
 
-    if (APP_RegsWriteHR(addr, val) != 1) {
-      resp_pdu[0] = (uint8_t)(fc | 0x80);
-      resp_pdu[1] = 0x02;
-      return 2;
-    }
+/* ------------------ TCP stream reassembly ------------------ */
 
-    /* hook: if MMM/SS changed -> P10 + log */
-    uint16_t m, s;
-    if (APP_RegsConsumeChangedTime(&m, &s)) {
-      APP_P10_SetTime(m, s);
-      APP_LogNotifyTime(m, s);
-    }
+static int serve_adu(void *ctx, const uint8_t *adu, uint16_t adu_len)
+{
+  mb_session_t *ss = (mb_session_t *)ctx;
 
-    /* echo request */
-    if (resp_cap < 5) return -1;
-    memcpy(resp_pdu, req_pdu, 5);
-    return 5;
+  /* cevap batch tamponuna yerinde yazilir; max ADU sigmiyorsa once flush,
+   * yine sigmiyorsa (peer okumuyor) parse durur */
+  if ((uint32_t)ss->tx_len + APP_MBAP_MAX_ADU > sizeof(ss->tx)) {
+    session_flush(ss, 1);
+    if (ss->conn == NULL || (uint32_t)ss->tx_len + APP_MBAP_MAX_ADU > sizeof(ss->tx)) return 0;
   }
 
-  /* 0x10 Write Multiple Holding Registers */
-  if (fc == 0x10) {
-    if (req_len < 6) return -1;
-    const uint16_t addr = be16_rd(&req_pdu[1]);
-    const uint16_t qty  = be16_rd(&req_pdu[3]);
-    const uint8_t  bc   = req_pdu[5];
-
-    if (qty == 0 || qty > 123 || bc != (uint8_t)(qty * 2) || req_len < (uint16_t)(6 + bc)) {
-      resp_pdu[0] = (uint8_t)(fc | 0x80);
-      resp_pdu[1] = 0x03;
-      return 2;
-    }
+  const uint16_t n = APP_ModbusServeAdu(adu, adu_len, &ss->tx[ss->tx_len], (uint8_t)(ss - s_sess));
+  if (n > 0) {
+    ss->tx_len = (uint16_t)(ss->tx_len + n);
+    ss->resp_count++;
+  }
+  return 1;
+}
+
+/* TCP is a stream: ADU'lar pbuf zinciri uzerinde rx_off'tan yerinde parse edilir.
+ * Donus: 1 = segment bitti, 0 = TX dolu, kalan kisim bekliyor */
+static int session_parse(mb_session_t *ss)
+{
+  uint32_t skip = ss->rx_off;
 
-    uint16_t tmp[123];
-    for (uint16_t i = 0; i < qty; ++i) {
-      tmp[i] = be16_rd(&req_pdu[6 + i * 2]);
+  for (struct pbuf *q = ss->rx_p; q != NULL; q = q->next) {
+    if (skip >= q->len) {
+      skip -= q->len;
+      continue;
     }
+    const size_t n = q->len - skip;
+    const size_t used = APP_MbapFeed(&ss->rx, (const uint8_t *)q->payload + skip, n, serve_adu, ss);
+    ss->rx_off = (uint16_t)(ss->rx_off + used);
+    if (used < n) return 0;
+    skip = 0;
+  }
+  return 1;
+}
 
-    if (APP_RegsWriteHRBlock(addr, tmp, qty) != qty) {
-      resp_pdu[0] = (uint8_t)(fc | 0x80);
-      resp_pdu[1] = 0x02;
-      return 2;
+/* Returns 1 if data was processed, 0 if idle. Closes the session on error/FIN. */
+static int session_service(mb_session_t *ss)
+{
+  /* once bekleyen cevaplar; gonderilemiyorsa bu session'dan yeni istek alinmaz */
+  if (ss->tx_len > 0) {
+    session_flush(ss, 0);
+    if (ss->conn == NULL) return 0;
+    if (ss->tx_len > 0) {
+      if ((osKernelGetTickCount() - ss->tx_stall_ms) >= APP_MODBUS_TX_STALL_MS) session_close(ss); /* olu peer */
+      return 0;
     }
+  }
 
-    /* hook: if MMM/SS changed -> P10 + log */
-    uint16_t m, s;
-    if (APP_RegsConsumeChangedTime(&m, &s)) {
-      APP_P10_SetTime(m, s);
-      APP_LogNotifyTime(m, s);
+  if (ss->rx_p == NULL) {
+    struct pbuf *p = NULL;
+    err_t err = netconn_recv_tcp_pbuf_flags(ss->conn, &p, NETCONN_DONTBLOCK);
+
+    if (err == ERR_WOULDBLOCK) return 0;
+    if (err != ERR_OK || p == NULL) {
+      session_close(ss); /* closed/reset/etc */
+      return 0;
     }
 
-    /* normal response: fc + addr + qty */
-    if (resp_cap < 5) return -1;
-    resp_pdu[0] = fc;
-    be16_wr(&resp_pdu[1], addr);
-    be16_wr(&resp_pdu[3], qty);
-    return 5;
+    ss->last_rx_ms = osKernelGetTickCount();
+    ss->rx_p = p;
+    ss->rx_off = 0;
+  }
+
+  if (session_parse(ss)) {
+    pbuf_free(ss->rx_p);
+    ss->rx_p = NULL;
   }
+  if (ss->conn == NULL) return 0;
 
-  /* unsupported */
-  resp_pdu[0] = (uint8_t)(fc | 0x80);
-  resp_pdu[1] = 0x01; /* ILLEGAL FUNCTION */
-  return 2;
+  /* batch basina tek gonderim */
+  const uint16_t pending = ss->tx_len;
+  session_flush(ss, 0);
+  if (ss->tx_len == pending && pending > 0) ss->tx_stall_ms = osKernelGetTickCount();
+  return 1;
 }
 
-/* ------------------ TCP stream reassembly ------------------ */
+/* ------------------ UDP ------------------ */
+
+#if APP_MODBUS_UDP_ENABLE
+static struct netconn *s_udp_conn = NULL;
+static uint8_t         s_udp_rx[APP_MBAP_MAX_ADU];
+static uint8_t         s_udp_tx[APP_MBAP_MAX_ADU];
 
-static void serve_conn(struct netconn *c)
+static void udp_open(void)
 {
-  /* TCP is a stream: Modbus ADU may arrive split or coalesced. */
-  uint8_t rx[512];
-  size_t  used = 0;
+#if APP_MODBUS_EVENT_DRIVEN
+  s_udp_conn = netconn_new_with_callback(NETCONN_UDP, mb_netconn_evt);
+#else
+  s_udp_conn = netconn_new(NETCONN_UDP);
+#endif
+  if (s_udp_conn == NULL) return;
 
-  for (;;) {
-    struct netbuf *inbuf = NULL;
-    err_t err = netconn_recv(c, &inbuf);
+  if (netconn_bind(s_udp_conn, IP_ADDR_ANY, APP_MODBUS_UDP_PORT) != ERR_OK) {
+    netconn_delete(s_udp_conn);
+    s_udp_conn = NULL;
+  }
+}
 
-    if (err == ERR_WOULDBLOCK) {
-      osDelay(5);
-      continue;
-    }
-    if (err != ERR_OK) {
-      break; /* closed/reset/etc */
-    }
+/* Returns 1 if a datagram was processed, 0 if idle. */
+static int udp_service(void)
+{
+  if (s_udp_conn == NULL) return 0;
+
+  struct netbuf *nb = NULL;
+  if (netconn_recv_udp_raw_netbuf_flags(s_udp_conn, &nb, NETCONN_DONTBLOCK) != ERR_OK || nb == NULL) {
+    return 0;
+  }
+
+  const uint16_t len = netbuf_len(nb);
+  const uint8_t *dgram = s_udp_rx;
+  uint16_t dlen = 0;
 
-    do {
-      void *data = NULL;
-      u16_t len = 0;
-      netbuf_data(inbuf, &data, &len);
-
-      if (len > 0 && data != NULL) {
-        /* append to rx buffer */
-        if (used + (size_t)len > sizeof(rx)) {
-          /* overflow -> drop buffer (safe choice) */
-          used = 0;
-        } else {
-          memcpy(&rx[used], data, (size_t)len);
-          used += (size_t)len;
-        }
-
-        /* parse as many complete ADU as possible */
-        for (;;) {
-          if (used < 7) break; /* need at least MBAP(7) */
-
-          const uint16_t tid = be16_rd(&rx[0]);
-          const uint16_t pid = be16_rd(&rx[2]);
-          const uint16_t mlen = be16_rd(&rx[4]); /* UID + PDU */
-
-          /* sanity */
-          if (pid != 0 || mlen < 2 || mlen > 253) {
-            used = 0; /* resync hard */
-            break;
-          }
-
-          const size_t adu_len = (size_t)6 + (size_t)mlen; /* (TID+PID+LEN)=6 + LEN */
-          if (used < adu_len) break; /* wait more */
-
-          /* ESKI:
-          const uint8_t uid = rx[6];
-          */
-          const uint8_t uid_req = rx[6];
-
-          /* YENI: UID filtrele (UID=10 degilse yok say) */
-          if (uid_req != (uint8_t)APP_MODBUS_UNIT_ID) {
-            /* Bu ADU'yu tuket, cevap verme */
-            const size_t rem_drop = used - adu_len;
-            if (rem_drop > 0) memmove(rx, rx + adu_len, rem_drop);
-            used = rem_drop;
-            continue;
-          }
-
-          const uint8_t *pdu = &rx[7];
-          const uint16_t pdu_len = (uint16_t)(adu_len - 7);
-
-          uint8_t tx[260];
-          be16_wr(&tx[0], tid);
-          be16_wr(&tx[2], 0);
-
-          /* ESKI:
-          tx[6] = uid;
-          */
-          /* YENI: her zaman Unit ID = 10 ile cevap ver */
-          tx[6] = (uint8_t)APP_MODBUS_UNIT_ID;
-
-          int resp_pdu_len = handle_pdu(pdu, pdu_len, &tx[7], (uint16_t)(sizeof(tx) - 7));
-          if (resp_pdu_len > 0) {
-            be16_wr(&tx[4], (uint16_t)(resp_pdu_len + 1)); /* UID + PDU */
-            (void)netconn_write(c, tx, (size_t)(7 + resp_pdu_len), NETCONN_COPY);
-          }
-
-          /* consume this ADU */
-          const size_t rem = used - adu_len;
-          if (rem > 0) memmove(rx, rx + adu_len, rem);
-          used = rem;
-        }
-      }
-
-    } while (netbuf_next(inbuf) >= 0);
-
-    netbuf_delete(inbuf);
+  if (nb->p->len == nb->p->tot_len) {
+    dgram = (const uint8_t *)nb->p->payload; /* tek pbuf: yerinde */
+    dlen = len;
+  } else if (len <= sizeof(s_udp_rx)) {
+    dlen = netbuf_copy(nb, s_udp_rx, len);   /* zincirli (nadir): kopyala */
   }
+
+  const uint16_t n = APP_ModbusServeDatagram(dgram, dlen, s_udp_tx);
+
+  if (n > 0) {
+    /* gelen netbuf'u cevap icin yeniden kullan (MEMP_NUM_NETBUF kucuk) */
+    ip_addr_t addr;
+    ip_addr_copy(addr, *netbuf_fromaddr(nb));
+    const u16_t port = netbuf_fromport(nb);
+
+    if (netbuf_ref(nb, s_udp_tx, n) == ERR_OK) {
+      (void)netconn_sendto(s_udp_conn, nb, &addr, port);
+    }
+  }
+
+  netbuf_delete(nb);
+  return 1;
+}
+#endif
+
+/* ------------------ stats ------------------ */
+
+static uint8_t netconn_get_conn_stats(uint8_t slot, app_modbus_conn_stats_t *out)
+{
+  if (!out || slot >= APP_MODBUS_MAX_CONN) return 0;
+
+  const mb_session_t *ss = &s_sess[slot];
+  out->active       = (ss->conn != NULL);
+  out->adu_count    = ss->rx.adu_count;
+  out->resp_count   = ss->resp_count;
+  out->tx_writes    = ss->tx_writes;
+  out->resp_per_write_x100 = ss->tx_writes ? (ss->resp_count * 100u) / ss->tx_writes : 0;
+  out->copied_bytes = ss->rx.copied_bytes;
+  out->resync_bytes = ss->rx.resync_bytes;
+  out->tx_stalls    = ss->tx_stalls;
+  return 1;
 }
 
 /* ------------------ task ------------------ */
 
-void APP_ModbusTask(void *argument)
+static void netconn_engine_run(void)
 {
-  (void)argument;
+  s_task = osThreadGetId();
 
+#if APP_MODBUS_EVENT_DRIVEN
+  struct netconn *listener = netconn_new_with_callback(NETCONN_TCP, mb_netconn_evt);
+#else
   struct netconn *listener = netconn_new(NETCONN_TCP);
+#endif
   if (listener == NULL) {
     for (;;) { osDelay(1000); }
   }
@@ -254,22 +324,78 @@ void APP_ModbusTask(void *argument)
   /* nonblocking accept loop */
   netconn_set_nonblocking(listener, 1);
 
+  memset(s_sess, 0, sizeof(s_sess));
+
+#if APP_MODBUS_UDP_ENABLE
+  udp_open();
+#endif
+
   for (;;) {
+    APP_SupervisorKick(APP_KICK_MODBUS);
+
+    int busy = 0;
+
     struct netconn *c = NULL;
     err_t err = netconn_accept(listener, &c);
-
     if (err == ERR_OK && c != NULL) {
-      /* nonblocking recv -> no LWIP_SO_RCVTIMEO dependency */
-      netconn_set_nonblocking(c, 1);
+      mb_session_t *ss = session_alloc();
+      session_reset(ss);
+      ss->conn = c;
+      ss->last_rx_ms = osKernelGetTickCount();
+      busy = 1;
+    }
 
-      serve_conn(c);
+    /* fair round-robin: her session tur basina en fazla bir segment */
+    for (uint32_t k = 0; k < APP_MODBUS_MAX_CONN; ++k) {
+      mb_session_t *ss = &s_sess[(s_rr + k) % APP_MODBUS_MAX_CONN];
+      if (ss->conn == NULL) continue;
+      busy |= session_service(ss);
+    }
+    s_rr = (uint8_t)((s_rr + 1u) % APP_MODBUS_MAX_CONN);
+
+#if APP_MODBUS_UDP_ENABLE
+    busy |= udp_service();
+#endif
 
-      netconn_close(c);
-      netconn_delete(c);
-    } else {
-      /* ERR_WOULDBLOCK */
-      osDelay(20);
+    if (!busy) {
+      /* ERR_WOULDBLOCK everywhere */
+#if APP_MODBUS_EVENT_DRIVEN
+      /* Flag bu turda set edildiyse hemen doner; kayip uyanma olmaz. */
+      (void)osThreadFlagsWait(MB_FLAG_NET, osFlagsWaitAny, APP_MODBUS_IDLE_WAIT_MS);
+#else
+      osDelay(5);
+#endif
     }
   }
 }
 
+#endif /* APP_MODBUS_ENGINE_NETCONN */
+
+/* ------------------ public ------------------ */
+
+uint8_t APP_ModbusGetConnStats(uint8_t slot, app_modbus_conn_stats_t *out)
+{
+#if APP_MODBUS_ENGINE == APP_MODBUS_ENGINE_RAW
+  return APP_ModbusRawGetConnStats(slot, out);
+#else
+  return netconn_get_conn_stats(slot, out);
+#endif
+}
+
+void APP_ModbusTask(void *argument)
+{
+  (void)argument;
+
+  APP_ModbusPduInit();
+
+#if APP_MODBUS_ENGINE == APP_MODBUS_ENGINE_RAW
+  /* Tum trafik tcpip_thread icindeki callback'lerde; bu task sadece supervisor'i besler. */
+  APP_ModbusRawStart();
+  for (;;) {
+    APP_SupervisorKick(APP_KICK_MODBUS);
+    osDelay(APP_MODBUS_IDLE_WAIT_MS);
+  }
+#else
+  netconn_engine_run();
+#endif
+}
@@ -0,0 +1,767 @@
+#include "app_modbus.h"
+
+#include "app_mbap.h"
+#include "app_regs.h"
+#include "app_hist.h"
+#include "app_config.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Modbus PDU engine (tum transport/engine'ler ortak kullanir).
+ *
+ * Function code -> handler eslemesi tablo ile: s_fc_index[fc] O(1) ile
+ * s_fc[] girisini bulur. Yeni FC eklemek icin APP_ModbusRegisterFc().
+ * Her giris icin istek/exception sayaci ve DWT cycle olcumu tutulur;
+ * bunlar APP_MODBUS_DIAG_HR_BASE'den itibaren FC03 ile okunabilir.
+ */
+
+#if APP_REGS_HR_EXT_COUNT > 0 && (APP_REGS_HR_EXT_BASE + APP_REGS_HR_EXT_COUNT) > APP_MODBUS_DIAG_HR_BASE
+#error "APP_REGS_HR_EXT_* diagnostics block (APP_MODBUS_DIAG_HR_BASE) ile cakisiyor"
+#endif
+
+/* ------------------ Unit ID ------------------ */
+
+/* ESKI: Unit ID sabit tanim yoktu, gelen UID aynen echo ediliyordu */
+#ifndef APP_MODBUS_UNIT_ID
+#define APP_MODBUS_UNIT_ID 10u
+#endif
+
+/* ------------------ helpers ------------------ */
+
+static uint16_t be16_rd(const uint8_t *p) {
+  return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+}
+static void be16_wr(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)(v & 0xFF);
+}
+
+int APP_ModbusException(uint8_t *resp_pdu, uint8_t fc, uint8_t code)
+{
+  resp_pdu[0] = (uint8_t)(fc | 0x80);
+  resp_pdu[1] = code;
+  return 2;
+}
+
+/* ------------------ function code table ------------------ */
+
+typedef struct {
+  uint8_t                 fc;
+  uint8_t                 min_len;   /* PDU min uzunluk (FC dahil) */
+  uint16_t                max_qty;   /* 0: qty alani yok; yoksa PDU[3..4] 1..max_qty */
+  app_modbus_fc_handler_t handler;
+  app_modbus_post_hook_t  post_hook; /* basarili istekten sonra */
+
+  uint32_t                req_count;
+  uint32_t                exc_count;
+  uint32_t                cyc_min;
+  uint32_t                cyc_max;
+  uint64_t                cyc_sum;
+} mb_fc_entry_t;
+
+static mb_fc_entry_t s_fc[APP_MODBUS_FC_TABLE_SIZE];
+static uint8_t       s_fc_count = 0;
+static uint8_t       s_fc_index[128]; /* fc -> s_fc slot + 1, 0 = unsupported */
+
+uint8_t APP_ModbusRegisterFc(uint8_t fc, uint8_t min_len, uint16_t max_qty,
+                             app_modbus_fc_handler_t handler,
+                             app_modbus_post_hook_t post_hook)
+{
+  if (fc == 0 || fc >= 0x80 || handler == NULL) return 0;
+
+  mb_fc_entry_t *e;
+  if (s_fc_index[fc] != 0) {
+    e = &s_fc[s_fc_index[fc] - 1u]; /* replace, counters kept */
+  } else {
+    if (s_fc_count >= APP_MODBUS_FC_TABLE_SIZE) return 0;
+    e = &s_fc[s_fc_count];
+    memset(e, 0, sizeof(*e));
+    e->cyc_min = UINT32_MAX;
+    s_fc_count++;
+  }
+
+  e->fc        = fc;
+  e->min_len   = min_len;
+  e->max_qty   = max_qty;
+  e->handler   = handler;
+  e->post_hook = post_hook;
+
+  /* index en son yazilir: yarim kayit dispatch'e gorunmez */
+  s_fc_index[fc] = (uint8_t)((e - s_fc) + 1);
+  return 1;
+}
+
+/* ------------------ unit routing ------------------ */
+
+static app_modbus_unit_t s_units[APP_MODBUS_MAX_UNITS];
+static uint8_t           s_unit_count = 0;
+static uint8_t           s_uid_index[256]; /* uid -> s_units slot + 1, 0 = unknown */
+
+uint8_t APP_ModbusRegisterUnit(uint8_t uid, app_regs_map_t *map)
+{
+  if (map == NULL) return 0;
+
+  app_modbus_unit_t *u;
+  if (s_uid_index[uid] != 0) {
+    u = &s_units[s_uid_index[uid] - 1u];
+  } else {
+    if (s_unit_count >= APP_MODBUS_MAX_UNITS) return 0;
+    u = &s_units[s_unit_count++];
+  }
+
+  u->uid = uid;
+  u->map = map;
+
+  /* diagnostics her unit'te ayni HR penceresinde (zaten ekliyse sayfa cakismasi, yok sayilir) */
+  (void)APP_RegsMapAddFn(map, APP_REGS_HR, APP_MODBUS_DIAG_HR_BASE, APP_MODBUS_DIAG_HR_COUNT,
+                         APP_ModbusDiagRead);
+
+  s_uid_index[uid] = (uint8_t)((u - s_units) + 1);
+  return 1;
+}
+
+/* ------------------ diagnostics block ------------------ */
+
+/*
+ * HR[APP_MODBUS_DIAG_HR_BASE + n], read-only:
+ *   +0 : layout version
+ *   +1 : registered FC count
+ *   +2..+3 : reserved
+ *   +4..+5 : FC03/FC04 response cache hit
+ *   +6..+7 : FC03/FC04 response cache miss
+ *   +8..+9 : hit basina ortalama cycle (read_words girisinden cevaba, DWT)
+ *   +10..+11 : miss basina ortalama cycle (bank okuma + serilestirme + cache doldurma)
+ *   +12 + i*12 : FC entry i
+ *       [0] fc, [1..2] req_count, [3..4] exc_count,
+ *       [5..6] cyc_min, [7..8] cyc_avg, [9..10] cyc_max, [11] reserved
+ *   32-bit alanlar hi word once.
+ */
+#define DIAG_VERSION     3u
+#define DIAG_HDR_REGS   12u
+#define DIAG_ENTRY_REGS 12u
+
+/* ------------------ read response cache ------------------ */
+
+/*
+ * FC03/FC04: ayni (map, tablo, adres, adet) penceresi tekrar okundugunda bank
+ * generation'i degismediyse serilestirilmis cevap PDU'su aynen kopyalanir
+ * (TID/MBAP ServeAdu'da yazilir). Fn region'lar (diagnostics) cache'lenmez.
+ * Degistirme: en dusuk skorlu slot; her yeni pencerede skorlar yaslanir,
+ * boylece surekli poll edilen pencereler tek seferlik okumalarla atilmaz.
+ * ServeAdu tek context'ten cagrildigi icin lock yok.
+ */
+typedef struct {
+  const app_regs_map_t *map; /* NULL: bos */
+  uint8_t  table;
+  uint16_t addr;
+  uint16_t qty;
+  uint32_t gen;
+  uint16_t score;
+  uint16_t len;
+  uint8_t  pdu[2 + 250];
+} resp_cache_t;
+
+static uint32_t s_rc_hits;
+static uint32_t s_rc_misses;
+static uint64_t s_rc_hit_cyc;  /* toplam cycle, ortalama = / hits */
+static uint64_t s_rc_miss_cyc;
+
+#if APP_MODBUS_RESP_CACHE_SLOTS > 0
+static resp_cache_t s_rc[APP_MODBUS_RESP_CACHE_SLOTS];
+
+static resp_cache_t *rc_find(const app_regs_map_t *m, uint8_t t, uint16_t addr, uint16_t qty)
+{
+  for (uint32_t i = 0; i < APP_MODBUS_RESP_CACHE_SLOTS; ++i) {
+    resp_cache_t *c = &s_rc[i];
+    if (c->map == m && c->table == t && c->addr == addr && c->qty == qty) return c;
+  }
+  return NULL;
+}
+
+static resp_cache_t *rc_claim(void)
+{
+  resp_cache_t *victim = &s_rc[0];
+  for (uint32_t i = 0; i < APP_MODBUS_RESP_CACHE_SLOTS; ++i) {
+    resp_cache_t *c = &s_rc[i];
+    if (c->score) c->score--;
+    if (c->score < victim->score) victim = c;
+  }
+  victim->map = NULL;
+  victim->score = 0;
+  return victim;
+}
+#endif
+
+static uint16_t diag_reg(uint16_t off)
+{
+  if (off == 0) return DIAG_VERSION;
+  if (off == 1) return s_fc_count;
+  if (off == 4) return (uint16_t)(s_rc_hits >> 16);
+  if (off == 5) return (uint16_t)s_rc_hits;
+  if (off == 6) return (uint16_t)(s_rc_misses >> 16);
+  if (off == 7) return (uint16_t)s_rc_misses;
+  if (off == 8 || off == 9) {
+    const uint32_t v = s_rc_hits ? (uint32_t)(s_rc_hit_cyc / s_rc_hits) : 0;
+    return (off == 8) ? (uint16_t)(v >> 16) : (uint16_t)v;
+  }
+  if (off == 10 || off == 11) {
+    const uint32_t v = s_rc_misses ? (uint32_t)(s_rc_miss_cyc / s_rc_misses) : 0;
+    return (off == 10) ? (uint16_t)(v >> 16) : (uint16_t)v;
+  }
+  if (off < DIAG_HDR_REGS) return 0;
+
+  const uint16_t i = (uint16_t)((off - DIAG_HDR_REGS) / DIAG_ENTRY_REGS);
+  const uint16_t k = (uint16_t)((off - DIAG_HDR_REGS) % DIAG_ENTRY_REGS);
+  if (i >= s_fc_count) return 0;
+
+  const mb_fc_entry_t *e = &s_fc[i];
+  uint32_t v = 0;
+  switch (k) {
+    case 0:           return e->fc;
+    case 1: case 2:   v = e->req_count; break;
+    case 3: case 4:   v = e->exc_count; break;
+    case 5: case 6:   v = e->req_count ? e->cyc_min : 0; break;
+    case 7: case 8:   v = e->req_count ? (uint32_t)(e->cyc_sum / e->req_count) : 0; break;
+    case 9: case 10:  v = e->cyc_max; break;
+    default:          return 0;
+  }
+  return (k & 1u) ? (uint16_t)(v >> 16) : (uint16_t)(v & 0xFFFFu);
+}
+
+uint16_t APP_ModbusDiagRead(uint16_t off, uint16_t *out, uint16_t qty)
+{
+  if (!out || qty == 0) return 0;
+  if ((uint32_t)off + qty > APP_MODBUS_DIAG_HR_COUNT) return 0;
+
+  for (uint16_t i = 0; i < qty; ++i) out[i] = diag_reg((uint16_t)(off + i));
+  return qty;
+}
+
+void APP_ModbusGetTotals(uint32_t *req, uint32_t *exc)
+{
+  uint32_t r = 0, x = 0;
+  for (uint8_t i = 0; i < s_fc_count; ++i) {
+    r += s_fc[i].req_count;
+    x += s_fc[i].exc_count;
+  }
+  if (req) *req = r;
+  if (exc) *exc = x;
+}
+
+/* ------------------ write history ------------------ */
+
+/* Islenen istegin kaynagi (ServeAdu'da set edilir; engine tek context): yazma gecmisi
+ * ve transaction sahipligi */
+static uint8_t s_req_src;
+
+/* Map yazma hatasi: transaction baska kaynakta acik -> SERVER DEVICE BUSY, diger -> adres */
+static int write_exception(uint8_t *resp_pdu, uint8_t fc, uint16_t rc)
+{
+  return APP_ModbusException(resp_pdu, fc, (rc == APP_REGS_BUSY) ? 0x06 : 0x02);
+}
+
+/* Basarili yazmada PLC'nin yazdigi degerler (app_hist) */
+static void hist_words(const app_modbus_unit_t *unit, uint8_t fc, uint16_t addr,
+                       const uint16_t *v, uint16_t qty)
+{
+#if APP_HIST_ENABLE
+  for (uint16_t i = 0; i < qty; ++i) {
+    APP_HistAppend(unit->uid, APP_REGS_HR, fc, s_req_src, (uint16_t)(addr + i), v[i]);
+  }
+#else
+  (void)unit; (void)fc; (void)addr; (void)v; (void)qty;
+#endif
+}
+
+static void hist_bits(const app_modbus_unit_t *unit, uint8_t fc, uint16_t addr,
+                      const uint8_t *packed, uint16_t qty)
+{
+#if APP_HIST_ENABLE
+  for (uint16_t i = 0; i < qty; ++i) {
+    APP_HistAppend(unit->uid, APP_REGS_COIL, fc, s_req_src, (uint16_t)(addr + i),
+                   (uint16_t)((packed[i >> 3] >> (i & 7u)) & 1u));
+  }
+#else
+  (void)unit; (void)fc; (void)addr; (void)packed; (void)qty;
+#endif
+}
+
+/* ------------------ function code handlers ------------------ */
+
+/* 0x01 / 0x02 ortak: bit tablosu oku, Modbus paketli */
+static int read_bits(const app_modbus_unit_t *unit, app_regs_table_t t,
+                     const uint8_t *req_pdu, uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t qty  = be16_rd(&req_pdu[3]);
+
+  const uint16_t bc = (uint16_t)((qty + 7u) / 8u);
+  if ((uint32_t)bc + 2U > resp_cap) return -1;
+
+  if (APP_RegsMapReadBits(unit->map, t, addr, &resp_pdu[2], qty) != qty) {
+    return APP_ModbusException(resp_pdu, fc, 0x02); /* ILLEGAL DATA ADDRESS */
+  }
+
+  resp_pdu[0] = fc;
+  resp_pdu[1] = (uint8_t)bc;
+  return (int)(2 + bc);
+}
+
+/* 0x03 / 0x04 ortak: word tablosu oku */
+static int read_words(const app_modbus_unit_t *unit, app_regs_table_t t,
+                      const uint8_t *req_pdu, uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t qty  = be16_rd(&req_pdu[3]);
+
+  const uint16_t bc = (uint16_t)(qty * 2);
+  if ((uint32_t)bc + 2U > resp_cap) return -1;
+
+#if APP_MODBUS_RESP_CACHE_SLOTS > 0
+  const uint32_t t0 = DWT->CYCCNT;
+
+  /* generation tek (yazma suruyor) ya da bank yok: cache disi */
+  const app_regs_region_t *r = APP_RegsMapFind(unit->map, t, addr, qty);
+  const uint32_t gen = (r && r->bank) ? APP_RegsBankGeneration(r->bank) : 1u;
+
+  resp_cache_t *c = NULL;
+  if ((gen & 1u) == 0) {
+    c = rc_find(unit->map, (uint8_t)t, addr, qty);
+    if (c && c->gen == gen) {
+      if (c->score < UINT16_MAX) c->score++;
+      s_rc_hits++;
+      memcpy(resp_pdu, c->pdu, c->len);
+      s_rc_hit_cyc += DWT->CYCCNT - t0;
+      return (int)c->len;
+    }
+    s_rc_misses++;
+  }
+#endif
+
+  /* lock-free: tcpip_thread (raw engine) icinden de guvenli */
+  uint16_t tmp[125];
+  if (APP_RegsMapRead(unit->map, t, addr, tmp, qty) != qty) {
+    return APP_ModbusException(resp_pdu, fc, 0x02); /* ILLEGAL DATA ADDRESS */
+  }
+
+  resp_pdu[0] = fc;
+  resp_pdu[1] = (uint8_t)bc;
+  for (uint16_t i = 0; i < qty; ++i) {
+    be16_wr(&resp_pdu[2 + i * 2], tmp[i]);
+  }
+
+#if APP_MODBUS_RESP_CACHE_SLOTS > 0
+  /* okuma sirasinda generation degismediyse cevap o generation'a ait */
+  if ((gen & 1u) == 0 && APP_RegsBankGeneration(r->bank) == gen) {
+    if (!c) c = rc_claim();
+    c->map   = unit->map;
+    c->table = (uint8_t)t;
+    c->addr  = addr;
+    c->qty   = qty;
+    c->gen   = gen;
+    c->len   = (uint16_t)(2 + bc);
+    if (c->score < UINT16_MAX) c->score++;
+    memcpy(c->pdu, resp_pdu, c->len);
+  }
+  if ((gen & 1u) == 0) s_rc_miss_cyc += DWT->CYCCNT - t0;
+#endif
+  return (int)(2 + bc);
+}
+
+/* 0x01 Read Coils */
+static int fc01_read_coils(const app_modbus_unit_t *unit,
+                           const uint8_t *req_pdu, uint16_t req_len,
+                           uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  return read_bits(unit, APP_REGS_COIL, req_pdu, resp_pdu, resp_cap);
+}
+
+/* 0x02 Read Discrete Inputs */
+static int fc02_read_di(const app_modbus_unit_t *unit,
+                        const uint8_t *req_pdu, uint16_t req_len,
+                        uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  return read_bits(unit, APP_REGS_DI, req_pdu, resp_pdu, resp_cap);
+}
+
+/* 0x03 Read Holding Registers (diagnostics block dahil) */
+static int fc03_read_hr(const app_modbus_unit_t *unit,
+                        const uint8_t *req_pdu, uint16_t req_len,
+                        uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  return read_words(unit, APP_REGS_HR, req_pdu, resp_pdu, resp_cap);
+}
+
+/* 0x04 Read Input Registers */
+static int fc04_read_ir(const app_modbus_unit_t *unit,
+                        const uint8_t *req_pdu, uint16_t req_len,
+                        uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  return read_words(unit, APP_REGS_IR, req_pdu, resp_pdu, resp_cap);
+}
+
+/* 0x05 Write Single Coil (0xFF00 = ON, 0x0000 = OFF) */
+static int fc05_write_coil(const app_modbus_unit_t *unit,
+                           const uint8_t *req_pdu, uint16_t req_len,
+                           uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t val  = be16_rd(&req_pdu[3]);
+
+  if (val != 0xFF00u && val != 0x0000u) return APP_ModbusException(resp_pdu, fc, 0x03);
+  const uint8_t on = (uint8_t)(val != 0);
+  if (APP_RegsMapWriteBit(unit->map, APP_REGS_COIL, addr, on) != 1) {
+    return APP_ModbusException(resp_pdu, fc, 0x02);
+  }
+  hist_bits(unit, fc, addr, &on, 1);
+
+  /* echo request */
+  if (resp_cap < 5) return -1;
+  memcpy(resp_pdu, req_pdu, 5);
+  return 5;
+}
+
+/* 0x06 Write Single Holding Register */
+static int fc06_write_hr(const app_modbus_unit_t *unit,
+                         const uint8_t *req_pdu, uint16_t req_len,
+                         uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t val  = be16_rd(&req_pdu[3]);
+
+  const uint16_t n = APP_RegsMapWrite(unit->map, s_req_src, APP_REGS_HR, addr, &val, 1);
+  if (n != 1) return write_exception(resp_pdu, fc, n);
+  hist_words(unit, fc, addr, &val, 1);
+
+  /* echo request */
+  if (resp_cap < 5) return -1;
+  memcpy(resp_pdu, req_pdu, 5);
+  return 5;
+}
+
+/* 0x0F Write Multiple Coils */
+static int fc0f_write_coils(const app_modbus_unit_t *unit,
+                            const uint8_t *req_pdu, uint16_t req_len,
+                            uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t qty  = be16_rd(&req_pdu[3]);
+  const uint8_t  bc   = req_pdu[5];
+
+  if (bc != (uint8_t)((qty + 7u) / 8u) || req_len < (uint16_t)(6 + bc)) {
+    return APP_ModbusException(resp_pdu, fc, 0x03);
+  }
+
+  if (APP_RegsMapWriteBits(unit->map, APP_REGS_COIL, addr, &req_pdu[6], qty) != qty) {
+    return APP_ModbusException(resp_pdu, fc, 0x02);
+  }
+  hist_bits(unit, fc, addr, &req_pdu[6], qty);
+
+  /* normal response: fc + addr + qty */
+  if (resp_cap < 5) return -1;
+  resp_pdu[0] = fc;
+  be16_wr(&resp_pdu[1], addr);
+  be16_wr(&resp_pdu[3], qty);
+  return 5;
+}
+
+/* 0x10 Write Multiple Holding Registers */
+static int fc10_write_hr_block(const app_modbus_unit_t *unit,
+                               const uint8_t *req_pdu, uint16_t req_len,
+                               uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  const uint8_t  fc   = req_pdu[0];
+  const uint16_t addr = be16_rd(&req_pdu[1]);
+  const uint16_t qty  = be16_rd(&req_pdu[3]);
+  const uint8_t  bc   = req_pdu[5];
+
+  if (bc != (uint8_t)(qty * 2) || req_len < (uint16_t)(6 + bc)) {
+    return APP_ModbusException(resp_pdu, fc, 0x03);
+  }
+
+  uint16_t tmp[123];
+  for (uint16_t i = 0; i < qty; ++i) {
+    tmp[i] = be16_rd(&req_pdu[6 + i * 2]);
+  }
+
+  const uint16_t n = APP_RegsMapWrite(unit->map, s_req_src, APP_REGS_HR, addr, tmp, qty);
+  if (n != qty) return write_exception(resp_pdu, fc, n);
+  hist_words(unit, fc, addr, tmp, qty);
+
+  /* normal response: fc + addr + qty */
+  if (resp_cap < 5) return -1;
+  resp_pdu[0] = fc;
+  be16_wr(&resp_pdu[1], addr);
+  be16_wr(&resp_pdu[3], qty);
+  return 5;
+}
+
+/* 0x16 Mask Write Register (atomic AND/OR) */
+static int fc16_mask_write_hr(const app_modbus_unit_t *unit,
+                              const uint8_t *req_pdu, uint16_t req_len,
+                              uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)req_len;
+  const uint8_t  fc       = req_pdu[0];
+  const uint16_t addr     = be16_rd(&req_pdu[1]);
+  const uint16_t and_mask = be16_rd(&req_pdu[3]);
+  const uint16_t or_mask  = be16_rd(&req_pdu[5]);
+
+  const uint16_t n = APP_RegsMapMaskWrite(unit->map, s_req_src, addr, and_mask, or_mask);
+  if (n != 1) return write_exception(resp_pdu, fc, n);
+#if APP_HIST_ENABLE
+  uint16_t cur;
+  if (APP_RegsMapRead(unit->map, APP_REGS_HR, addr, &cur, 1) == 1) hist_words(unit, fc, addr, &cur, 1);
+#endif
+
+  /* echo request */
+  if (resp_cap < 7) return -1;
+  memcpy(resp_pdu, req_pdu, 7);
+  return 7;
+}
+
+/* 0x17 Read/Write Multiple Registers (write first, then read; atomic) */
+static int fc17_read_write_hr(const app_modbus_unit_t *unit,
+                              const uint8_t *req_pdu, uint16_t req_len,
+                              uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  const uint8_t  fc    = req_pdu[0];
+  const uint16_t raddr = be16_rd(&req_pdu[1]);
+  const uint16_t rqty  = be16_rd(&req_pdu[3]);
+  const uint16_t waddr = be16_rd(&req_pdu[5]);
+  const uint16_t wqty  = be16_rd(&req_pdu[7]);
+  const uint8_t  wbc   = req_pdu[9];
+
+  if (wqty == 0 || wqty > 121 || wbc != (uint8_t)(wqty * 2) || req_len < (uint16_t)(10 + wbc)) {
+    return APP_ModbusException(resp_pdu, fc, 0x03);
+  }
+
+  uint16_t wtmp[121];
+  for (uint16_t i = 0; i < wqty; ++i) {
+    wtmp[i] = be16_rd(&req_pdu[10 + i * 2]);
+  }
+
+  uint16_t rtmp[125];
+  const uint16_t n = APP_RegsMapReadWrite(unit->map, s_req_src, waddr, wtmp, wqty, raddr, rtmp, rqty);
+  if (n != 1) return write_exception(resp_pdu, fc, n);
+  hist_words(unit, fc, waddr, wtmp, wqty);
+
+  const uint16_t bc = (uint16_t)(rqty * 2);
+  if ((uint32_t)bc + 2U > resp_cap) return -1;
+
+  resp_pdu[0] = fc;
+  resp_pdu[1] = (uint8_t)bc;
+  for (uint16_t i = 0; i < rqty; ++i) {
+    be16_wr(&resp_pdu[2 + i * 2], rtmp[i]);
+  }
+  return (int)(2 + bc);
+}
+
+/* 0x14 Read File Record: alt istek = ref type (6) + file + record + length.
+ * file 0/1: register yazma gecmisi (app_hist.h), tum unit'lerde ayni */
+static int fc14_read_file_record(const app_modbus_unit_t *unit,
+                                 const uint8_t *req_pdu, uint16_t req_len,
+                                 uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  (void)unit;
+  const uint8_t fc = req_pdu[0];
+  const uint8_t bc = req_pdu[1];
+
+  if (bc < 7u || bc > 0xF5u || (bc % 7u) != 0 || req_len < (uint16_t)(2 + bc)) {
+    return APP_ModbusException(resp_pdu, fc, 0x03);
+  }
+
+  /* cevap data uzunlugu <= 0xF5 (spec) */
+  const uint16_t cap = (resp_cap < 2u + 0xF5u) ? resp_cap : (uint16_t)(2u + 0xF5u);
+  uint16_t pos = 2;
+  for (uint16_t i = 0; i < bc; i += 7u) {
+    const uint8_t *sub  = &req_pdu[2 + i];
+    const uint16_t file = be16_rd(&sub[1]);
+    const uint16_t rec  = be16_rd(&sub[3]);
+    const uint16_t len  = be16_rd(&sub[5]);
+
+    if (sub[0] != 6u || rec > 9999u) return APP_ModbusException(resp_pdu, fc, 0x02);
+    if (len == 0 || (uint32_t)pos + 2u + (uint32_t)len * 2u > cap) {
+      return APP_ModbusException(resp_pdu, fc, 0x03);
+    }
+
+    uint16_t tmp[121];
+#if APP_HIST_ENABLE
+    if (APP_HistReadFile(file, rec, tmp, len) != len) return APP_ModbusException(resp_pdu, fc, 0x02);
+#else
+    (void)file; (void)tmp;
+    return APP_ModbusException(resp_pdu, fc, 0x02);
+#endif
+
+    resp_pdu[pos++] = (uint8_t)(1u + len * 2u);
+    resp_pdu[pos++] = 6u;
+    for (uint16_t k = 0; k < len; ++k) {
+      be16_wr(&resp_pdu[pos], tmp[k]);
+      pos = (uint16_t)(pos + 2u);
+    }
+  }
+
+  resp_pdu[0] = fc;
+  resp_pdu[1] = (uint8_t)(pos - 2u);
+  return (int)pos;
+}
+
+/* ------------------ init ------------------ */
+
+static void dwt_cyccnt_enable(void)
+{
+  /* sayac sifirlanmaz: FreeRTOS run-time stats ayni sayaci kullanir (app_metrics.c) */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void APP_ModbusPduInit(void)
+{
+  static uint8_t inited = 0;
+  if (inited) return;
+  inited = 1;
+
+  dwt_cyccnt_enable();
+#if APP_HIST_ENABLE
+  APP_HistInit();
+#endif
+
+  /*                   fc    min_len max_qty handler              post_hook */
+  APP_ModbusRegisterFc(0x01, 5,      2000,   fc01_read_coils,     NULL);
+  APP_ModbusRegisterFc(0x02, 5,      2000,   fc02_read_di,        NULL);
+  APP_ModbusRegisterFc(0x03, 5,      125,    fc03_read_hr,        NULL);
+  APP_ModbusRegisterFc(0x04, 5,      125,    fc04_read_ir,        NULL);
+  APP_ModbusRegisterFc(0x05, 5,      0,      fc05_write_coil,     NULL);
+  APP_ModbusRegisterFc(0x06, 5,      0,      fc06_write_hr,       NULL);
+  APP_ModbusRegisterFc(0x0F, 6,      1968,   fc0f_write_coils,    NULL);
+  APP_ModbusRegisterFc(0x10, 6,      123,    fc10_write_hr_block, NULL);
+  APP_ModbusRegisterFc(0x14, 9,      0,      fc14_read_file_record, NULL);
+  APP_ModbusRegisterFc(0x16, 7,      0,      fc16_mask_write_hr,  NULL);
+  APP_ModbusRegisterFc(0x17, 10,     125,    fc17_read_write_hr,  NULL);
+
+  /* ana unit: MMM/SS degisimi P10 + log'a app_regs change notification ile gider */
+  APP_ModbusRegisterUnit((uint8_t)APP_MODBUS_UNIT_ID, APP_RegsMainMap());
+
+#if APP_MODBUS_ZONE_UNIT_COUNT > 0
+  for (uint8_t i = 0; i < APP_MODBUS_ZONE_UNIT_COUNT; ++i) {
+    APP_ModbusRegisterUnit((uint8_t)(APP_MODBUS_ZONE_UNIT_BASE + i), APP_RegsZoneMap(i));
+  }
+#endif
+}
+
+/* ------------------ Modbus PDU dispatch ------------------ */
+
+static int handle_pdu(const app_modbus_unit_t *unit,
+                      const uint8_t *req_pdu, uint16_t req_len,
+                      uint8_t *resp_pdu, uint16_t resp_cap)
+{
+  if (req_len < 1) return -1;
+  const uint8_t fc = req_pdu[0];
+
+  const uint8_t slot = (fc < 0x80) ? s_fc_index[fc] : 0;
+  if (slot == 0) {
+    /* unsupported */
+    return APP_ModbusException(resp_pdu, fc, 0x01); /* ILLEGAL FUNCTION */
+  }
+
+  mb_fc_entry_t *e = &s_fc[slot - 1u];
+  if (req_len < e->min_len) return -1;
+
+  const uint32_t t0 = DWT->CYCCNT;
+
+  int n;
+  if (e->max_qty != 0 &&
+      (be16_rd(&req_pdu[3]) == 0 || be16_rd(&req_pdu[3]) > e->max_qty)) {
+    n = APP_ModbusException(resp_pdu, fc, 0x03); /* ILLEGAL DATA VALUE */
+  } else {
+    n = e->handler(unit, req_pdu, req_len, resp_pdu, resp_cap);
+  }
+
+  if (n >= 2 && (resp_pdu[0] & 0x80)) {
+    e->exc_count++;
+  } else if (n > 0 && e->post_hook != NULL) {
+    /* FC'ye ozgu istek sonrasi hook (APP_ModbusRegisterFc ile eklenen FC'ler) */
+    e->post_hook(unit);
+  }
+
+  const uint32_t cyc = DWT->CYCCNT - t0;
+  e->req_count++;
+  e->cyc_sum += cyc;
+  if (cyc < e->cyc_min) e->cyc_min = cyc;
+  if (cyc > e->cyc_max) e->cyc_max = cyc;
+
+  return n;
+}
+
+/* ------------------ ADU (MBAP + PDU) ------------------ */
+
+uint16_t APP_ModbusServeAdu(const uint8_t *adu, uint16_t adu_len, uint8_t *tx, uint8_t src)
+{
+  if (adu_len < APP_MBAP_HDR_LEN + 1u) return 0;
+
+  const uint16_t tid = be16_rd(&adu[0]);
+
+  const uint8_t uid_req = adu[6];
+
+  const uint8_t *pdu = &adu[7];
+  const uint16_t pdu_len = (uint16_t)(adu_len - 7);
+
+  be16_wr(&tx[0], tid);
+  be16_wr(&tx[2], 0);
+
+  /* ESKI: UID=10 degilse yok say (master timeout'a kadar bekliyordu)
+   * YENI: UID routing tablosu; cevap istenen UID ile doner */
+  tx[6] = uid_req;
+
+  int resp_pdu_len;
+  const uint8_t slot = s_uid_index[uid_req];
+  if (slot == 0) {
+    /* bilinmeyen unit: GATEWAY TARGET DEVICE FAILED TO RESPOND */
+    resp_pdu_len = APP_ModbusException(&tx[7], pdu[0], 0x0B);
+  } else {
+    s_req_src = src;
+    resp_pdu_len = handle_pdu(&s_units[slot - 1u], pdu, pdu_len, &tx[7], (uint16_t)(APP_MBAP_MAX_ADU - 7));
+  }
+  if (resp_pdu_len <= 0) return 0;
+
+  be16_wr(&tx[4], (uint16_t)(resp_pdu_len + 1)); /* UID + PDU */
+  return (uint16_t)(7 + resp_pdu_len);
+}
+
+/* ------------------ Modbus/UDP ------------------ */
+
+static app_modbus_udp_stats_t s_udp;
+
+uint16_t APP_ModbusServeDatagram(const uint8_t *dgram, uint16_t len, uint8_t *tx)
+{
+  /* UDP'de stream yok: datagram tam olarak bir ADU olmali */
+  if (len < APP_MBAP_HDR_LEN + 1u || len > APP_MBAP_MAX_ADU || APP_MbapFrameLen(dgram) != len) {
+    s_udp.drop_count++;
+    return 0;
+  }
+
+  s_udp.rx_count++;
+  const uint16_t n = APP_ModbusServeAdu(dgram, len, tx, APP_MODBUS_SRC_UDP);
+  if (n > 0) s_udp.tx_count++;
+  return n;
+}
+
+void APP_ModbusGetUdpStats(app_modbus_udp_stats_t *out)
+{
+  if (!out) return;
+  *out = s_udp;
+}
@@ -0,0 +1,366 @@
+#include "app_modbus.h"
+
+#include "app_mbap.h"
+#include "app_config.h"
+
+#if APP_MODBUS_ENGINE == APP_MODBUS_ENGINE_RAW
+
+#include "cmsis_os.h"
+
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+#include "lwip/pbuf.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * lwIP raw API Modbus engine.
+ *
+ * recv -> MBAP parse -> APP_ModbusServeAdu -> tcp_write hepsi tcpip_thread
+ * icindeki callback'lerde calisir. netconn recvmbox / tcpip mbox hop'lari ve
+ * modbus task context switch'i yok.
+ *
+ * Modbus/UDP (APP_MODBUS_UDP_ENABLE) ayni sekilde udp_recv callback'inde cevaplanir.
+ *
+ * Backpressure: TX tamponu gonderilemezse (peer okumuyor) parse durur, segmentin
+ * kalani session'da tutulur ve tcp_recved ertelenir (window kapanir). Bu sirada gelen
+ * yeni segmentler ERR_MEM ile reddedilir (lwIP refused_data olarak tutar, sonra tekrar
+ * verir). tcp_sent / tcp_poll'da TX bosalinca parse kaldigi ADU'dan devam eder.
+ *
+ * Not: HR okumalari lock-free (APP_RegsReadHRBlock, seqlock); yazmalar kisa
+ * sureligine hr_mutex alir (priority inheritance ile).
+ */
+
+/* handle_pdu tcpip_thread stack'inde calisir (yerel istek/cevap tamponlari ~0.5 KB).
+ * lwipopts.h / MODBUS.ioc 2048 veriyor; CubeMX eski degeri geri yazarsa burada durur */
+#if TCPIP_THREAD_STACKSIZE < 2048
+#error "APP_MODBUS_ENGINE_RAW icin TCPIP_THREAD_STACKSIZE >= 2048 olmali (MODBUS.ioc / lwipopts.h)"
+#endif
+
+/* tcp_poll araligi: 2 x 500 ms coarse timer */
+#define RAW_POLL_INTERVAL 2u
+
+typedef struct {
+  struct tcp_pcb *pcb;
+  uint32_t        last_rx_ms;
+  app_mbap_rx_t   rx;
+
+  /* parse'i TX yuzunden yarim kalan segment (tcp_recved bekliyor) */
+  struct pbuf    *rx_p;
+  uint16_t        rx_off;
+
+  /* coalesced TX; sndbuf yetmezse tcp_sent/tcp_poll'da tekrar denenir */
+  uint16_t        tx_len;
+  uint8_t         tx[APP_MODBUS_TX_BATCH_SIZE];
+
+  uint32_t        resp_count;
+  uint32_t        tx_writes;
+  uint32_t        tx_stalls;  /* TX dolu, parse bekletildi */
+} raw_session_t;
+
+static raw_session_t   s_rs[APP_MODBUS_MAX_CONN];
+static struct tcp_pcb *s_listen_pcb = NULL;
+
+/* ------------------ session helpers ------------------ */
+
+static void rs_drop_rx(raw_session_t *rs)
+{
+  if (rs->rx_p == NULL) return;
+  pbuf_free(rs->rx_p);
+  rs->rx_p = NULL;
+}
+
+static void rs_detach(raw_session_t *rs)
+{
+  struct tcp_pcb *pcb = rs->pcb;
+  rs_drop_rx(rs);
+  if (pcb == NULL) return;
+
+  APP_RegsTxnRelease((uint8_t)(rs - s_rs)); /* slot yeniden kullanilacak */
+  tcp_arg(pcb, NULL);
+  tcp_recv(pcb, NULL);
+  tcp_sent(pcb, NULL);
+  tcp_err(pcb, NULL);
+  tcp_poll(pcb, NULL, 0);
+  rs->pcb = NULL;
+}
+
+/* ERR_ABRT donerse pcb abort edildi; recv callback'i bunu aynen dondurmeli */
+static err_t rs_close(raw_session_t *rs)
+{
+  struct tcp_pcb *pcb = rs->pcb;
+  if (pcb == NULL) return ERR_OK;
+
+  rs_detach(rs);
+  if (tcp_close(pcb) != ERR_OK) {
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+  return ERR_OK;
+}
+
+static void rs_reset(raw_session_t *rs)
+{
+  APP_MbapReset(&rs->rx);
+  rs->rx_p = NULL;
+  rs->rx_off = 0;
+  rs->tx_len = 0;
+  rs->resp_count = 0;
+  rs->tx_writes = 0;
+  rs->tx_stalls = 0;
+}
+
+static raw_session_t *rs_alloc(void)
+{
+  raw_session_t *lru = &s_rs[0];
+
+  for (uint32_t i = 0; i < APP_MODBUS_MAX_CONN; ++i) {
+    raw_session_t *rs = &s_rs[i];
+    if (rs->pcb == NULL) return rs;
+    if ((int32_t)(rs->last_rx_ms - lru->last_rx_ms) < 0) lru = rs;
+  }
+
+  /* pool full -> evict least-recently-active client */
+  struct tcp_pcb *old = lru->pcb;
+  rs_detach(lru);
+  tcp_abort(old);
+  return lru;
+}
+
+static void rs_flush(raw_session_t *rs, uint8_t more)
+{
+  if (rs->tx_len == 0 || rs->pcb == NULL) return;
+  if (tcp_sndbuf(rs->pcb) < rs->tx_len) return;
+
+  const err_t err = tcp_write(rs->pcb, rs->tx, rs->tx_len,
+                              (u8_t)(TCP_WRITE_FLAG_COPY | (more ? TCP_WRITE_FLAG_MORE : 0)));
+  if (err != ERR_OK) return; /* ERR_MEM: queue dolu, sonra tekrar */
+
+  rs->tx_len = 0;
+  rs->tx_writes++;
+  if (!more) (void)tcp_output(rs->pcb);
+}
+
+static int rs_serve_adu(void *ctx, const uint8_t *adu, uint16_t adu_len)
+{
+  raw_session_t *rs = (raw_session_t *)ctx;
+
+  if ((uint32_t)rs->tx_len + APP_MBAP_MAX_ADU > sizeof(rs->tx)) {
+    rs_flush(rs, 1);
+    if ((uint32_t)rs->tx_len + APP_MBAP_MAX_ADU > sizeof(rs->tx)) {
+      rs->tx_stalls++;
+      return 0; /* sndbuf dolu: bu ADU'dan sonra devam */
+    }
+  }
+
+  const uint16_t n = APP_ModbusServeAdu(adu, adu_len, &rs->tx[rs->tx_len], (uint8_t)(rs - s_rs));
+  if (n > 0) {
+    rs->tx_len = (uint16_t)(rs->tx_len + n);
+    rs->resp_count++;
+  }
+  return 1;
+}
+
+/* Tutulan segmenti rx_off'tan parse et; bitince window'u ac. Sonra batch'i gonder. */
+static void rs_resume(raw_session_t *rs)
+{
+  uint32_t skip = rs->rx_off;
+  uint8_t done = 1;
+
+  for (struct pbuf *q = rs->rx_p; q != NULL; q = q->next) {
+    if (skip >= q->len) {
+      skip -= q->len;
+      continue;
+    }
+    const size_t n = q->len - skip;
+    const size_t used = APP_MbapFeed(&rs->rx, (const uint8_t *)q->payload + skip, n, rs_serve_adu, rs);
+    rs->rx_off = (uint16_t)(rs->rx_off + used);
+    if (used < n) {
+      done = 0;
+      break;
+    }
+    skip = 0;
+  }
+
+  if (done) {
+    if (rs->pcb != NULL) tcp_recved(rs->pcb, rs->rx_p->tot_len);
+    rs_drop_rx(rs);
+  }
+  rs_flush(rs, 0);
+}
+
+/* ------------------ lwIP callbacks (tcpip_thread) ------------------ */
+
+static err_t rs_recv_cb(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  raw_session_t *rs = (raw_session_t *)arg;
+
+  if (rs == NULL) {
+    if (p) pbuf_free(p);
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+
+  if (p == NULL) {
+    return rs_close(rs); /* FIN */
+  }
+
+  if (err != ERR_OK) {
+    pbuf_free(p);
+    return err;
+  }
+
+  /* onceki segment TX bekliyor: lwIP tutsun, sonra tekrar versin (pbuf pool'u
+   * tek istemci tuketmez; yeni data peer'de retransmit ile bekler) */
+  if (rs->rx_p != NULL) return ERR_MEM;
+
+  rs->last_rx_ms = osKernelGetTickCount();
+  rs->rx_p = p;
+  rs->rx_off = 0;
+  rs_resume(rs);
+  return ERR_OK;
+}
+
+/* TX ilerledi: bekleyen batch'i gonder, parse'i kaldigi yerden surdur */
+static void rs_kick(raw_session_t *rs)
+{
+  rs_flush(rs, 0);
+  if (rs->rx_p != NULL && rs->tx_len == 0) rs_resume(rs);
+}
+
+static err_t rs_sent_cb(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+  (void)pcb;
+  (void)len;
+  raw_session_t *rs = (raw_session_t *)arg;
+  if (rs) rs_kick(rs);
+  return ERR_OK;
+}
+
+static err_t rs_poll_cb(void *arg, struct tcp_pcb *pcb)
+{
+  (void)pcb;
+  raw_session_t *rs = (raw_session_t *)arg;
+  if (rs) rs_kick(rs);
+  return ERR_OK;
+}
+
+static void rs_err_cb(void *arg, err_t err)
+{
+  (void)err;
+  raw_session_t *rs = (raw_session_t *)arg;
+  if (rs) {
+    rs->pcb = NULL; /* pcb lwIP tarafinda zaten free edildi */
+    rs_drop_rx(rs);
+    APP_RegsTxnRelease((uint8_t)(rs - s_rs)); /* RST / timeout: staged yazmalar atilir */
+  }
+}
+
+static err_t rs_accept_cb(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  (void)arg;
+  if (err != ERR_OK || newpcb == NULL) return ERR_VAL;
+
+  raw_session_t *rs = rs_alloc();
+  rs_reset(rs);
+  rs->pcb = newpcb;
+  rs->last_rx_ms = osKernelGetTickCount();
+
+  tcp_arg(newpcb, rs);
+  tcp_recv(newpcb, rs_recv_cb);
+  tcp_sent(newpcb, rs_sent_cb);
+  tcp_err(newpcb, rs_err_cb);
+  tcp_poll(newpcb, rs_poll_cb, RAW_POLL_INTERVAL);
+  return ERR_OK;
+}
+
+/* ------------------ Modbus/UDP (tcpip_thread) ------------------ */
+
+#if APP_MODBUS_UDP_ENABLE
+static struct udp_pcb *s_udp_pcb = NULL;
+static uint8_t         s_udp_rx[APP_MBAP_MAX_ADU];
+static uint8_t         s_udp_tx[APP_MBAP_MAX_ADU];
+
+static void udp_recv_cb(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                        const ip_addr_t *addr, u16_t port)
+{
+  (void)arg;
+
+  const uint8_t *dgram = s_udp_rx;
+  uint16_t dlen = 0;
+
+  if (p->len == p->tot_len) {
+    dgram = (const uint8_t *)p->payload; /* tek pbuf: yerinde */
+    dlen = p->tot_len;
+  } else if (p->tot_len <= sizeof(s_udp_rx)) {
+    dlen = pbuf_copy_partial(p, s_udp_rx, p->tot_len, 0); /* zincirli (nadir) */
+  }
+
+  const uint16_t n = APP_ModbusServeDatagram(dgram, dlen, s_udp_tx);
+  if (n > 0) {
+    struct pbuf *q = pbuf_alloc(PBUF_TRANSPORT, n, PBUF_RAM);
+    if (q != NULL) {
+      memcpy(q->payload, s_udp_tx, n);
+      (void)udp_sendto(pcb, q, addr, port);
+      pbuf_free(q);
+    }
+  }
+
+  pbuf_free(p);
+}
+#endif
+
+/* ------------------ public ------------------ */
+
+void APP_ModbusRawStart(void)
+{
+  LOCK_TCPIP_CORE();
+
+  memset(s_rs, 0, sizeof(s_rs));
+
+  struct tcp_pcb *pcb = tcp_new();
+  if (pcb != NULL) {
+    if (tcp_bind(pcb, IP_ADDR_ANY, APP_MODBUS_TCP_PORT) == ERR_OK) {
+      s_listen_pcb = tcp_listen(pcb);
+      if (s_listen_pcb != NULL) {
+        tcp_accept(s_listen_pcb, rs_accept_cb);
+      }
+    } else {
+      (void)tcp_close(pcb);
+    }
+  }
+
+#if APP_MODBUS_UDP_ENABLE
+  s_udp_pcb = udp_new();
+  if (s_udp_pcb != NULL) {
+    if (udp_bind(s_udp_pcb, IP_ADDR_ANY, APP_MODBUS_UDP_PORT) == ERR_OK) {
+      udp_recv(s_udp_pcb, udp_recv_cb, NULL);
+    } else {
+      udp_remove(s_udp_pcb);
+      s_udp_pcb = NULL;
+    }
+  }
+#endif
+
+  UNLOCK_TCPIP_CORE();
+}
+
+uint8_t APP_ModbusRawGetConnStats(uint8_t slot, app_modbus_conn_stats_t *out)
+{
+  if (!out || slot >= APP_MODBUS_MAX_CONN) return 0;
+
+  const raw_session_t *rs = &s_rs[slot];
+  out->active       = (rs->pcb != NULL);
+  out->adu_count    = rs->rx.adu_count;
+  out->resp_count   = rs->resp_count;
+  out->tx_writes    = rs->tx_writes;
+  out->resp_per_write_x100 = rs->tx_writes ? (rs->resp_count * 100u) / rs->tx_writes : 0;
+  out->copied_bytes = rs->rx.copied_bytes;
+  out->resync_bytes = rs->rx.resync_bytes;
+  out->tx_stalls    = rs->tx_stalls;
+  return 1;
+}
+
+#endif /* APP_MODBUS_ENGINE_RAW */
@@ -299,6 +299,9 @@ void APP_P10_Task(void *argument)
 {
   (void)argument;
 
+  /* once abone ol, sonra ilk degeri oku: arada gelen yazma kaybolmaz */
+  const int8_t sub = APP_RegsSubscribeHook(APP_REGS_NOTIFY_FLAG, APP_REGS_HOOK_TIME);
+
   uint16_t m = 0, s = 0;
   APP_RegsGetTime(&m, &s);
   APP_P10_SetTime(m, s);
@@ -307,11 +310,11 @@ void APP_P10_Task(void *argument)
   {
     APP_SupervisorKick(APP_KICK_P10);
 
-    /* PLC yazınca panel anında güncellensin */
-    if (APP_RegsConsumeChangedTime(&m, &s)) {
+    /* PLC yazınca panel anında güncellensin (bildirim ile uyan, 50 ms polling yok) */
+    (void)osThreadFlagsWait(APP_REGS_NOTIFY_FLAG, osFlagsWaitAny, APP_P10_IDLE_WAIT_MS);
+    if (sub < 0 || APP_RegsTakeChanges(sub, NULL)) {
+      APP_RegsGetTime(&m, &s);
       APP_P10_SetTime(m, s);
     }
-
-    osDelay(50);
   }
 }
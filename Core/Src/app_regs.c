@@ -1,176 +1,1097 @@
 #include "app_regs.h"
 #include <string.h>
 
-/* Holding registers */
+/* Holding registers (ana bank, Unit ID = APP_MODBUS_UNIT_ID) */
 static uint16_t g_hr[APP_MODBUS_HR_COUNT];
-static osMutexId_t g_hr_mutex;
+#if APP_REGS_TXN_ENABLE
+static uint16_t g_hr_shadow[APP_MODBUS_HR_COUNT]; /* transaction staging; commit'te g_hr ile yer degistirir */
+#endif
+static app_regs_bank_t g_main;
 
-/* Change detection for MMM/SS */
-static uint16_t s_last_m = 0xFFFF;
-static uint16_t s_last_s = 0xFFFF;
-static uint8_t  s_time_dirty = 1;
+static app_regs_map_t  g_main_map;
 
-static uint8_t valid_addr(uint16_t addr)
+#if APP_REGS_HR_EXT_COUNT > 0
+static uint16_t g_hr_ext[APP_REGS_HR_EXT_COUNT];
+static app_regs_bank_t g_hr_ext_bank;
+#endif
+#if APP_REGS_IR_COUNT > 0
+static uint16_t g_ir[APP_REGS_IR_COUNT];
+static app_regs_bank_t g_ir_bank;
+#endif
+/* Bit store'lar bit-band bolgesinde olmali (RAM, CCMRAM degil) */
+#if APP_REGS_COIL_COUNT > 0
+static uint32_t g_coil[APP_REGS_BITS_WORDS(APP_REGS_COIL_COUNT)];
+static app_regs_bits_t g_coil_bits;
+#endif
+#if APP_REGS_DI_COUNT > 0
+static uint32_t g_di[APP_REGS_BITS_WORDS(APP_REGS_DI_COUNT)];
+static app_regs_bits_t g_di_bits;
+#endif
+
+#if APP_MODBUS_ZONE_UNIT_COUNT > 0
+/* Ek sanal slave'ler (display zone vb.) icin bagimsiz banklar */
+static uint16_t g_zone_hr[APP_MODBUS_ZONE_UNIT_COUNT][APP_MODBUS_ZONE_HR_COUNT];
+static app_regs_bank_t g_zone[APP_MODBUS_ZONE_UNIT_COUNT];
+static app_regs_map_t  g_zone_map[APP_MODBUS_ZONE_UNIT_COUNT];
+#endif
+
+/* Change notification: subscriber basina watch + dirty bitmap (cursor) */
+typedef struct {
+  osThreadId_t task;
+  uint32_t     flag;
+  uint32_t     watch[APP_REGS_HR_WORDS];
+  uint32_t     dirty[APP_REGS_HR_WORDS]; /* writer OR'lar, subscriber exchange ile alir */
+} chg_sub_t;
+
+static chg_sub_t s_sub[APP_REGS_MAX_SUBS];
+static uint8_t   s_sub_count = 0;
+static uint16_t  s_notify_last[APP_MODBUS_HR_COUNT]; /* son bildirilen degerler (mutex altinda) */
+
+static uint8_t valid_range(const app_regs_bank_t *b, uint16_t addr, uint16_t qty)
 {
-  return (addr < APP_MODBUS_HR_COUNT);
+  return (qty != 0 && (uint32_t)addr + (uint32_t)qty <= (uint32_t)b->count);
 }
 
-/* PLC contract clamp: MMM 0..999, SS 0..59 */
-static inline uint16_t clamp_hr(uint16_t addr, uint16_t v)
+/* ------------------ metadata (APP_HR_TABLE) ------------------ */
+
+#define HR_CHECK(name, addr, type, mn, mx, acc, hook, ret) \
+  _Static_assert((addr) + APP_REGS_T_WORDS_##type <= APP_MODBUS_HR_COUNT, "APP_HR_" #name " HR map disinda");
+APP_HR_TABLE(HR_CHECK)
+
+typedef struct {
+  uint16_t        addr;
+  uint8_t         words;
+  app_regs_meta_t meta;
+} hr_def_t;
+
+#define HR_DEF(name, addr, type, mn, mx, acc, hook, ret) \
+  { (addr), APP_REGS_T_WORDS_##type, \
+    { (mn), (mx), APP_REGS_T_##type, APP_REGS_A_##acc, APP_REGS_HOOK_##hook, 0, APP_REGS_R_##ret } },
+static const hr_def_t s_hr_defs[] = { APP_HR_TABLE(HR_DEF) };
+
+#define HR_CSV(name, addr, type, mn, mx, acc, hook, ret) \
+  #name "," #addr "," #type "," #mn "," #mx "," #acc "," #hook "," #ret "\r\n"
+#if APP_REGS_TXN_ENABLE
+/* TXN_CTRL tablo disinda (kendi region'i); adres degisirse satiri da guncelle */
+_Static_assert(APP_REGS_TXN_CTRL_ADDR == 3840u, "REGMAP.CSV TXN_CTRL satiri");
+#define HR_CSV_TXN "TXN_CTRL,3840,U16,0,2,RW,NONE,VOL\r\n"
+#else
+#define HR_CSV_TXN ""
+#endif
+static const char s_hr_csv[] = "name,addr,type,min,max,access,hook,retain\r\n" APP_HR_TABLE(HR_CSV) HR_CSV_TXN;
+
+/* Ana bank icin adres basina kural tablosu (APP_RegsInit'te s_hr_defs'ten) */
+static app_regs_meta_t s_main_meta[APP_MODBUS_HR_COUNT];
+
+static void meta_build(app_regs_meta_t *meta, uint16_t count, const hr_def_t *defs, uint32_t ndefs)
 {
-  if (addr == APP_HR_MINUTES) {
-    if (v > 999u) v = 999u;
-  } else if (addr == APP_HR_SECONDS) {
-    if (v > 59u) v = 59u;
+  for (uint16_t a = 0; a < count; ++a) {
+    meta[a] = (app_regs_meta_t){ .min = 0, .max = 0xFFFF, .type = APP_REGS_T_U16 };
   }
-  return v;
+  for (uint32_t i = 0; i < ndefs; ++i) {
+    for (uint8_t k = 0; k < defs[i].words; ++k) {
+      meta[defs[i].addr + k] = defs[i].meta;
+      meta[defs[i].addr + k].part = k;
+    }
+  }
+}
+
+/* Tek word tiplerde min/max; iki word'luk tiplerin word'leri tek basina clamp edilmez */
+static uint16_t meta_clamp(const app_regs_meta_t *m, uint16_t v)
+{
+  if (m->type > APP_REGS_T_I16) return v;
+
+  const int32_t x = (m->type == APP_REGS_T_I16) ? (int32_t)(int16_t)v : (int32_t)v;
+  return (uint16_t)(x < m->min ? m->min : (x > m->max ? m->max : x));
+}
+
+
+/* Modbus yazma izni: aralikta RO register varsa ya da cok word'lu bir deger
+ * yarim kaliyorsa (tearing) 0 */
+static uint8_t meta_writable(const app_regs_bank_t *b, uint16_t addr, uint16_t qty)
+{
+  if (!b->meta) return 1;
+
+  const app_regs_meta_t *first = &b->meta[addr];
+  const app_regs_meta_t *last  = &b->meta[addr + qty - 1u];
+  if (first->part != 0) return 0;
+  if ((uint8_t)(last->part + 1u) != APP_REGS_TYPE_WORDS(last->type)) return 0;
+
+  uint8_t acc = 0;
+  for (uint16_t i = 0; i < qty; ++i) acc |= b->meta[addr + i].access;
+  return (acc == APP_REGS_A_RW);
 }
 
-/* Must be called while mutex is held */
-static void mark_time_dirty_locked(void)
+/*
+ * Writer sequence: tek = yazma suruyor. Writer'lar mutex altinda ve IRQ kapali
+ * artirir; boylece yuksek oncelikli bir reader (tcpip_thread) yarim kalmis
+ * bir yazmanin uzerinde donmez, sadece kendisi kesildiyse tekrar dener.
+ * PRIMASK saklanip geri yuklenir: cagiran zaten IRQ kapali bir bolgedeyse
+ * (veya ic ice cagrida) seq_write_end IRQ'lari erken acmaz.
+ */
+/* Must be called while mutex is held; donus seq_write_end'e verilir */
+static inline uint32_t seq_write_begin(volatile uint32_t *seq)
 {
-  const uint16_t m = g_hr[APP_HR_MINUTES];
-  const uint16_t s = g_hr[APP_HR_SECONDS];
+  const uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  (*seq)++;
+  __DMB();
+  return pm;
+}
+
+static inline void seq_write_end(volatile uint32_t *seq, uint32_t pm)
+{
+  __DMB();
+  (*seq)++;
+  __set_PRIMASK(pm);
+}
+
+/*
+ * Ana bank on_write (mutex altinda): degeri gercekten degisen register'lari
+ * her subscriber'in kendi dirty bitmap'ine ekle ve task'ini uyandir.
+ * Her subscriber kendi bitmap'ini tuketir; biri digerinin olayini alamaz.
+ */
+static void main_on_write_locked(uint16_t addr, uint16_t qty, uint32_t hooks)
+{
+  (void)hooks;
 
-  if (m != s_last_m || s != s_last_s) {
-    s_time_dirty = 1;
+  uint32_t chg[APP_REGS_HR_WORDS] = { 0 };
+  uint8_t any = 0;
+  for (uint16_t i = 0; i < qty; ++i) {
+    const uint16_t a = (uint16_t)(addr + i);
+    if (g_main.hr[a] != s_notify_last[a]) {
+      s_notify_last[a] = g_main.hr[a];
+      chg[a >> 5] |= 1u << (a & 31u);
+      any = 1;
+    }
+  }
+  if (!any) return;
+
+  for (uint8_t k = 0; k < s_sub_count; ++k) {
+    chg_sub_t *sub = &s_sub[k];
+    uint32_t hit = 0;
+    for (uint32_t w = 0; w < APP_REGS_HR_WORDS; ++w) {
+      const uint32_t p = chg[w] & sub->watch[w];
+      if (p) {
+        (void)__atomic_fetch_or(&sub->dirty[w], p, __ATOMIC_RELEASE);
+        hit = 1;
+      }
+    }
+    if (hit) (void)osThreadFlagsSet(sub->task, sub->flag);
   }
 }
 
-void APP_RegsInit(void)
+/* Must be called while mutex is held; dst = write_begin_locked() donusu.
+ * Donus: yazilan adreslerin hook maskesi */
+static uint32_t write_block_locked(app_regs_bank_t *b, uint16_t *dst, uint16_t addr, const uint16_t* in, uint16_t qty)
 {
-  const osMutexAttr_t attr = { .name = "hr_mutex" };
-  g_hr_mutex = osMutexNew(&attr);
+  const app_regs_meta_t *meta = b->meta;
+  if (!meta) {
+    for (uint16_t i = 0; i < qty; ++i) dst[addr + i] = in[i];
+    return 0;
+  }
 
-  memset(g_hr, 0, sizeof(g_hr));
-  g_hr[APP_HR_MINUTES]    = 0;
-  g_hr[APP_HR_SECONDS]    = 0;
-  g_hr[APP_HR_YEAR]       = 1970;
-  g_hr[APP_HR_MONTH]      = 1;
-  g_hr[APP_HR_DAY]        = 1;
-  g_hr[APP_HR_LOG_ENABLE] = 1;
+  uint32_t hooks = 0;
+  for (uint16_t i = 0; i < qty; ++i) {
+    const app_regs_meta_t *m = &meta[addr + i];
+    dst[addr + i] = meta_clamp(m, in[i]);
+    hooks |= APP_REGS_HOOK_BIT(m->hook);
+  }
+  return hooks & ~APP_REGS_HOOK_BIT(APP_REGS_HOOK_NONE);
+}
+
+/* ------------------ transaction (shadow + generation swap) ------------------ */
 
-  s_last_m = 0xFFFF;
-  s_last_s = 0xFFFF;
-  s_time_dirty = 1;
+/*
+ * TXN_CTRL bank'in word'lerinden biri degil (APP_RegsMapAddTxn ile ayri region): blok
+ * yazmalar ona hic dokunmaz. BEGIN yazilinca yayinlanan buffer shadow'a kopyalanir ve
+ * BEGIN'i yazan kaynagin (owner) sonraki yazmalari shadow'a gider (reader'lar gormez). COMMIT'te
+ * hr/shadow pointer'lari tek seq bolgesinde yer degistirir: reader'lar ya eski ya yeni
+ * grubun tamamini gorur. Eski buffer'i okumakta olan reader seq degistigi icin tekrar dener.
+ *
+ * Transaction acikken baska bir Modbus kaynaginin yazmalari (TXN_CTRL dahil)
+ * APP_REGS_BUSY ile reddedilir (exception 0x06); aksi halde ACK'lenip abort/timeout'ta
+ * kaybolurlardi. Firmware ici yazmalar (APP_REGS_SRC_LOCAL) hemen yayinlanir ve
+ * shadow'a da yansitilir, commit onlari geri almaz.
+ */
+static void txn_abort_locked(app_regs_bank_t *b)
+{
+  b->txn_open  = 0;
+  b->txn_state = APP_REGS_TXN_IDLE;
 }
 
-uint16_t APP_RegsReadHR(uint16_t addr)
+static void txn_begin_locked(app_regs_bank_t *b, uint8_t src)
 {
-  if (!valid_addr(addr)) return 0;
+  memcpy(b->shadow, b->hr, (size_t)b->count * sizeof(uint16_t));
+  b->txn_open  = 1;
+  b->txn_owner = src;
+  b->txn_t0    = osKernelGetTickCount();
+  b->txn_lo    = 0xFFFFu;
+  b->txn_hi    = 0;
+  b->txn_hooks = 0;
+  b->txn_state = APP_REGS_TXN_BEGIN;
+}
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
-  uint16_t v = g_hr[addr];
-  osMutexRelease(g_hr_mutex);
+static void txn_commit_locked(app_regs_bank_t *b)
+{
+  uint16_t *pub = b->shadow;
+  const uint32_t pm = seq_write_begin(&b->seq);
+  b->shadow = b->hr;
+  b->hr     = pub; /* generation pointer swap */
+  seq_write_end(&b->seq, pm);
 
-  return v;
+  b->txn_open  = 0;
+  b->txn_state = APP_REGS_TXN_IDLE;
+  if (b->on_write_locked && b->txn_lo <= b->txn_hi) {
+    b->on_write_locked(b->txn_lo, (uint16_t)(b->txn_hi - b->txn_lo + 1u), b->txn_hooks);
+  }
 }
 
-uint16_t APP_RegsReadHRBlock(uint16_t addr, uint16_t* out, uint16_t qty)
+/* Terk edilmis transaction (istemci koptu): timeout sonra staged yazmalar atilir */
+static void txn_expire_locked(app_regs_bank_t *b)
+{
+  if (b->txn_open && (osKernelGetTickCount() - b->txn_t0) > APP_REGS_TXN_TIMEOUT_MS) {
+    txn_abort_locked(b);
+  }
+}
+
+/* Transaction baska bir Modbus kaynaginda acik mi (yerel yazmalar hic bloklanmaz) */
+static uint8_t txn_foreign_locked(const app_regs_bank_t *b, uint8_t src)
 {
-  if (!out) return 0;
-  if (qty == 0) return 0;
-  if ((uint32_t)addr + (uint32_t)qty > (uint32_t)APP_MODBUS_HR_COUNT) return 0;
+  return (b->txn_open && src != b->txn_owner && src != APP_REGS_SRC_LOCAL);
+}
+
+/* Donus: 1 = OK, 0 = gecersiz komut, APP_REGS_BUSY = baska kaynagin transaction'i acik */
+static uint16_t txn_ctrl_locked(app_regs_bank_t *b, uint8_t src, uint16_t cmd)
+{
+  txn_expire_locked(b);
+  if (txn_foreign_locked(b, src)) return APP_REGS_BUSY;
+
+  switch (cmd) {
+    case APP_REGS_TXN_BEGIN:  txn_begin_locked(b, src); return 1; /* owner tekrar yazarsa bastan baslar */
+    case APP_REGS_TXN_COMMIT: if (b->txn_open) txn_commit_locked(b); return 1;
+    case APP_REGS_TXN_IDLE:   if (b->txn_open) txn_abort_locked(b); return 1;
+    default:                  return 0;
+  }
+}
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
-  for (uint16_t i = 0; i < qty; ++i) out[i] = g_hr[addr + i];
-  osMutexRelease(g_hr_mutex);
+/* Yazma hedefi: owner'in transaction'i aciksa shadow (gorunmez), degilse yayinlanan
+ * buffer (seq ile). NULL: baska kaynagin transaction'i acik (APP_REGS_BUSY). */
+static uint16_t *write_begin_locked(app_regs_bank_t *b, uint8_t src)
+{
+  txn_expire_locked(b);
+  if (b->txn_open && src == b->txn_owner) return b->shadow;
+  if (txn_foreign_locked(b, src)) return NULL;
+
+  b->irq_pm = seq_write_begin(&b->seq);
+  return b->hr;
+}
+
+static void write_end_locked(app_regs_bank_t *b, uint8_t src, uint16_t addr, uint16_t qty, uint32_t hooks)
+{
+  if (b->txn_open) {
+    if (src == b->txn_owner) {
+      /* bildirim commit'te */
+      if (addr < b->txn_lo) b->txn_lo = addr;
+      if ((uint16_t)(addr + qty - 1u) > b->txn_hi) b->txn_hi = (uint16_t)(addr + qty - 1u);
+      b->txn_hooks |= hooks;
+      return;
+    }
+    /* yerel yazma yayinlandi; commit swap'i geri almasin diye shadow'a da */
+    memcpy(&b->shadow[addr], &b->hr[addr], (size_t)qty * sizeof(uint16_t));
+  }
+
+  seq_write_end(&b->seq, b->irq_pm);
+  if (b->on_write_locked) b->on_write_locked(addr, qty, hooks);
+}
+
+/* ------------------ generic bank API ------------------ */
+
+void APP_RegsBankInit(app_regs_bank_t *b, uint16_t *storage, uint16_t count,
+                      const app_regs_meta_t *meta, app_regs_write_fn on_write_locked,
+                      const char *name)
+{
+  const osMutexAttr_t attr = { .name = name };
+
+  memset(storage, 0, (size_t)count * sizeof(uint16_t));
+  b->hr     = storage;
+  b->shadow = NULL;
+  b->count  = count;
+  b->meta   = meta;
+  b->on_write_locked = on_write_locked;
+  b->seq    = 0;
+  b->txn_open = 0;
+  b->txn_state = APP_REGS_TXN_IDLE;
+  b->txn_owner = APP_REGS_SRC_LOCAL;
+  b->mutex  = osMutexNew(&attr);
+}
+
+void APP_RegsBankEnableTxn(app_regs_bank_t *b, uint16_t *shadow)
+{
+  if (!b || !shadow) return;
+
+  osMutexAcquire(b->mutex, osWaitForever);
+  b->txn_open  = 0;
+  b->txn_state = APP_REGS_TXN_IDLE;
+  b->shadow    = shadow;
+  osMutexRelease(b->mutex);
+}
+
+uint16_t APP_RegsBankTxnCtrl(app_regs_bank_t *b, uint8_t src, uint16_t cmd)
+{
+  if (!b || !b->shadow) return 0;
+
+  osMutexAcquire(b->mutex, osWaitForever);
+  const uint16_t rc = txn_ctrl_locked(b, src, cmd);
+  osMutexRelease(b->mutex);
+  return rc;
+}
+
+uint16_t APP_RegsBankTxnState(const app_regs_bank_t *b)
+{
+  return b ? b->txn_state : (uint16_t)APP_REGS_TXN_IDLE;
+}
+
+void APP_RegsBankTxnRelease(app_regs_bank_t *b, uint8_t src)
+{
+  if (!b || !b->shadow) return;
 
+  osMutexAcquire(b->mutex, osWaitForever);
+  if (b->txn_open && b->txn_owner == src) txn_abort_locked(b);
+  osMutexRelease(b->mutex);
+}
+
+void APP_RegsBankTick(app_regs_bank_t *b)
+{
+  if (!b || !b->shadow) return;
+
+  /* mesgulse bekleme: yazan taraf da write_begin'de expire eder */
+  if (osMutexAcquire(b->mutex, 0) != osOK) return;
+  txn_expire_locked(b);
+  osMutexRelease(b->mutex);
+}
+
+/* Seqlock reader: writer yoksa tek geciste biter, yazma (veya commit swap'i) araya girdiyse tekrar dener */
+static void seq_read(const app_regs_bank_t *b, uint16_t addr, uint16_t* out, uint16_t qty)
+{
+  for (;;) {
+    const uint32_t s0 = b->seq;
+    if (s0 & 1u) continue; /* writer in progress */
+    __DMB();
+    const volatile uint16_t *hr = b->hr;
+    for (uint16_t i = 0; i < qty; ++i) out[i] = hr[addr + i];
+    __DMB();
+    if (b->seq == s0) break;
+  }
+}
+
+uint32_t APP_RegsBankGeneration(const app_regs_bank_t *b)
+{
+  const uint32_t g = b->seq;
+  __DMB();
+  return g;
+}
+
+uint16_t APP_RegsBankRead(app_regs_bank_t *b, uint16_t addr, uint16_t* out, uint16_t qty)
+{
+  if (!b || !out) return 0;
+  if (!valid_range(b, addr, qty)) return 0;
+
+  seq_read(b, addr, out, qty);
   return qty;
 }
 
-uint16_t APP_RegsWriteHR(uint16_t addr, uint16_t value)
+uint16_t APP_RegsBankWrite(app_regs_bank_t *b, uint8_t src, uint16_t addr, const uint16_t* in, uint16_t qty)
 {
-  if (!valid_addr(addr)) return 0;
+  if (!b || !in) return 0;
+  if (!valid_range(b, addr, qty)) return 0;
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
+  osMutexAcquire(b->mutex, osWaitForever);
 
-  value = clamp_hr(addr, value);
-  g_hr[addr] = value;
+  uint16_t *dst = write_begin_locked(b, src);
+  if (!dst) {
+    osMutexRelease(b->mutex);
+    return APP_REGS_BUSY;
+  }
+  const uint32_t hooks = write_block_locked(b, dst, addr, in, qty);
+  write_end_locked(b, src, addr, qty, hooks);
+
+  osMutexRelease(b->mutex);
+  return qty;
+}
+
+uint16_t APP_RegsBankReadWrite(app_regs_bank_t *b, uint8_t src,
+                               uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                               uint16_t raddr, uint16_t* out, uint16_t rqty)
+{
+  if (!b || !in || !out) return 0;
+  if (!valid_range(b, waddr, wqty)) return 0;
+  if (!valid_range(b, raddr, rqty)) return 0;
 
-  if (addr == APP_HR_MINUTES || addr == APP_HR_SECONDS) {
-    mark_time_dirty_locked();
+  osMutexAcquire(b->mutex, osWaitForever);
+
+  /* FC23: once yaz, sonra oku; tek kritik bolge (transaction icinde kendi staged degerleri) */
+  uint16_t *dst = write_begin_locked(b, src);
+  if (!dst) {
+    osMutexRelease(b->mutex);
+    return APP_REGS_BUSY;
   }
+  const uint32_t hooks = write_block_locked(b, dst, waddr, in, wqty);
+  for (uint16_t i = 0; i < rqty; ++i) out[i] = dst[raddr + i];
+  write_end_locked(b, src, waddr, wqty, hooks);
 
-  osMutexRelease(g_hr_mutex);
+  osMutexRelease(b->mutex);
   return 1;
 }
 
-uint16_t APP_RegsWriteHRBlock(uint16_t addr, const uint16_t* in, uint16_t qty)
+uint16_t APP_RegsBankMaskWrite(app_regs_bank_t *b, uint8_t src, uint16_t addr, uint16_t and_mask, uint16_t or_mask)
 {
-  if (!in) return 0;
-  if (qty == 0) return 0;
-  if ((uint32_t)addr + (uint32_t)qty > (uint32_t)APP_MODBUS_HR_COUNT) return 0;
+  if (!b) return 0;
+  if (!valid_range(b, addr, 1)) return 0;
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
+  osMutexAcquire(b->mutex, osWaitForever);
 
-  for (uint16_t i = 0; i < qty; ++i) {
-    const uint16_t a = (uint16_t)(addr + i);
-    uint16_t v = clamp_hr(a, in[i]);
-    g_hr[a] = v;
+  /* FC22: result = (current AND and_mask) OR (or_mask AND (NOT and_mask)) */
+  uint16_t *dst = write_begin_locked(b, src);
+  if (!dst) {
+    osMutexRelease(b->mutex);
+    return APP_REGS_BUSY;
+  }
+  const uint16_t cur = dst[addr];
+  const uint16_t v = (uint16_t)((cur & and_mask) | (or_mask & (uint16_t)~and_mask));
+
+  const uint32_t hooks = write_block_locked(b, dst, addr, &v, 1);
+  write_end_locked(b, src, addr, 1, hooks);
+
+  osMutexRelease(b->mutex);
+  return 1;
+}
+
+/* ------------------ bit store ------------------ */
+
+/*
+ * Coil/DI word'leri SRAM1/SRAM2'de (.bss, 0x2000_0000..) durur; bu aralik Cortex-M4
+ * bit-band bolgesi. Tek bit yazma alias word'une tek store: donanim RMW'yi atomik
+ * yapar, mutex / IRQ kapatma gerekmez (FC05, uygulama DI guncellemesi).
+ * Storage bit-band disindaysa (CCMRAM) ya da hedef ARM degilse __atomic fallback.
+ */
+#if defined(SRAM1_BASE) && defined(SRAM1_BB_BASE)
+#define BITS_BB_SIZE 0x100000u /* bit-band ile erisilen 1 MB SRAM penceresi */
+
+static volatile uint32_t *bitband_alias(const uint32_t *w)
+{
+  const uint32_t a = (uint32_t)(uintptr_t)w;
+  if (a < SRAM1_BASE || a >= SRAM1_BASE + BITS_BB_SIZE) return NULL;
+  return (volatile uint32_t *)(SRAM1_BB_BASE + (a - SRAM1_BASE) * 32u);
+}
+#else
+static volatile uint32_t *bitband_alias(const uint32_t *w)
+{
+  (void)w;
+  return NULL;
+}
+#endif
+
+void APP_RegsBitsInit(app_regs_bits_t *b, uint32_t *storage, uint16_t count)
+{
+  memset(storage, 0, (size_t)APP_REGS_BITS_WORDS(count) * sizeof(uint32_t));
+  b->w     = storage;
+  b->bb    = bitband_alias(storage);
+  b->count = count;
+  b->seq   = 0;
+}
+
+static uint8_t bits_valid(const app_regs_bits_t *b, uint16_t addr, uint16_t qty)
+{
+  return (qty != 0 && (uint32_t)addr + (uint32_t)qty <= (uint32_t)b->count);
+}
+
+/* packed[] icinden bit i'den baslayan n (<= 32) biti al */
+static uint32_t packed_get(const uint8_t *packed, uint32_t i, uint32_t n)
+{
+  const uint32_t b0 = i >> 3;
+  const uint32_t nb = ((i & 7u) + n + 7u) / 8u;
+  uint64_t v = 0;
+  for (uint32_t k = 0; k < nb; ++k) v |= (uint64_t)packed[b0 + k] << (8u * k);
+  return (uint32_t)(v >> (i & 7u));
+}
+
+/*
+ * Word-wide paketli okuma: her cikis byte'i en fazla iki word'den shift ile.
+ * Seq sadece cok bitli yazmalarda (FC0F) artar; araya giren tek bit yazmasi
+ * (bit-band) her zaman gercek bir ara durumu gosterir.
+ */
+uint16_t APP_RegsBitsRead(app_regs_bits_t *b, uint16_t addr, uint8_t *packed, uint16_t qty)
+{
+  if (!b || !packed) return 0;
+  if (!bits_valid(b, addr, qty)) return 0;
+
+  const volatile uint32_t *w = b->w;
+  const uint32_t nwords = APP_REGS_BITS_WORDS(b->count);
+  const uint16_t nbytes = (uint16_t)((qty + 7u) / 8u);
+
+  for (;;) {
+    const uint32_t s0 = b->seq;
+    if (s0 & 1u) continue; /* writer in progress */
+    __DMB();
+    for (uint16_t k = 0; k < nbytes; ++k) {
+      const uint32_t a  = (uint32_t)addr + 8u * k;
+      const uint32_t wi = a >> 5;
+      const uint32_t sh = a & 31u;
+      uint32_t v = w[wi] >> sh;
+      if (sh > 24u && wi + 1u < nwords) v |= w[wi + 1u] << (32u - sh);
+      packed[k] = (uint8_t)v;
+    }
+    __DMB();
+    if (b->seq == s0) break;
   }
 
-  const uint32_t a0 = (uint32_t)addr;
-  const uint32_t e0 = a0 + (uint32_t)qty;
-  if ((a0 <= (uint32_t)APP_HR_MINUTES && e0 > (uint32_t)APP_HR_MINUTES) ||
-      (a0 <= (uint32_t)APP_HR_SECONDS && e0 > (uint32_t)APP_HR_SECONDS))
-  {
-    mark_time_dirty_locked();
+  if (qty & 7u) packed[nbytes - 1u] &= (uint8_t)((1u << (qty & 7u)) - 1u);
+  return qty;
+}
+
+/* Cok bitli yazma (FC0F): word basina tek masked store; IRQ kapali oldugundan
+ * tek cekirdekte bit-band yazicilari ile de yarismaz, mutex gerekmez. */
+uint16_t APP_RegsBitsWrite(app_regs_bits_t *b, uint16_t addr, const uint8_t *packed, uint16_t qty)
+{
+  if (!b || !packed) return 0;
+  if (!bits_valid(b, addr, qty)) return 0;
+
+  const uint32_t pm = seq_write_begin(&b->seq);
+  uint32_t a = addr;
+  uint32_t i = 0;
+  while (i < qty) {
+    const uint32_t sh = a & 31u;
+    uint32_t n = 32u - sh;
+    if (n > (uint32_t)qty - i) n = (uint32_t)qty - i;
+
+    const uint32_t mask = ((n == 32u) ? 0xFFFFFFFFu : ((1u << n) - 1u)) << sh;
+    const uint32_t v    = packed_get(packed, i, n) << sh;
+    b->w[a >> 5] = (b->w[a >> 5] & ~mask) | (v & mask);
+
+    i += n;
+    a += n;
   }
+  seq_write_end(&b->seq, pm);
 
-  osMutexRelease(g_hr_mutex);
   return qty;
 }
 
+uint16_t APP_RegsBitsSet(app_regs_bits_t *b, uint16_t addr, uint8_t v)
+{
+  if (!b) return 0;
+  if (!bits_valid(b, addr, 1)) return 0;
+
+  if (b->bb) {
+    b->bb[addr] = v ? 1u : 0u; /* tek store, atomik */
+  } else {
+    const uint32_t m = 1u << (addr & 31u);
+    if (v) (void)__atomic_fetch_or(&b->w[addr >> 5], m, __ATOMIC_RELAXED);
+    else   (void)__atomic_fetch_and(&b->w[addr >> 5], ~m, __ATOMIC_RELAXED);
+  }
+  return 1;
+}
+
+uint8_t APP_RegsBitsGet(const app_regs_bits_t *b, uint16_t addr)
+{
+  if (!b || !bits_valid(b, addr, 1)) return 0;
+
+  if (b->bb) return (uint8_t)(b->bb[addr] & 1u);
+  return (uint8_t)((((volatile const uint32_t *)b->w)[addr >> 5] >> (addr & 31u)) & 1u);
+}
+
+/* ------------------ register map ------------------ */
+
+void APP_RegsMapInit(app_regs_map_t *m)
+{
+  memset(m, 0, sizeof(*m));
+  m->word_order = (uint8_t)APP_REGS_WORD_ORDER;
+}
+
+static uint8_t map_add(app_regs_map_t *m, app_regs_table_t t, const app_regs_region_t *r)
+{
+  if (!m || (uint32_t)t >= APP_REGS_TABLES || r->count == 0) return 0;
+  if ((uint32_t)r->start + r->count > 0x10000u) return 0;
+  if (m->nregion[t] >= APP_REGS_MAX_REGIONS) return 0;
+
+  const uint32_t p0 = (uint32_t)r->start >> APP_REGS_PAGE_SHIFT;
+  const uint32_t p1 = ((uint32_t)r->start + r->count - 1u) >> APP_REGS_PAGE_SHIFT;
+  for (uint32_t p = p0; p <= p1; ++p) {
+    if (m->page[t][p] != 0) return 0; /* sayfa baska region'da */
+  }
+
+  const uint8_t slot = m->nregion[t]++;
+  m->region[t][slot] = *r;
+  for (uint32_t p = p0; p <= p1; ++p) m->page[t][p] = (uint8_t)(slot + 1u);
+  return 1;
+}
+
+uint8_t APP_RegsMapAddWords(app_regs_map_t *m, app_regs_table_t t, uint16_t start, app_regs_bank_t *bank)
+{
+  if (!bank || t == APP_REGS_COIL || t == APP_REGS_DI) return 0;
+  const app_regs_region_t r = { .start = start, .count = bank->count, .bank = bank };
+  return map_add(m, t, &r);
+}
+
+uint8_t APP_RegsMapAddBits(app_regs_map_t *m, app_regs_table_t t, uint16_t start, app_regs_bits_t *bits)
+{
+  if (!bits || (t != APP_REGS_COIL && t != APP_REGS_DI)) return 0;
+  const app_regs_region_t r = { .start = start, .count = bits->count, .bits = bits };
+  return map_add(m, t, &r);
+}
+
+uint8_t APP_RegsMapAddFn(app_regs_map_t *m, app_regs_table_t t, uint16_t start, uint16_t count,
+                         app_regs_read_fn read)
+{
+  if (!read || t == APP_REGS_COIL || t == APP_REGS_DI) return 0;
+  const app_regs_region_t r = { .start = start, .count = count, .read = read };
+  return map_add(m, t, &r);
+}
+
+uint8_t APP_RegsMapAddTxn(app_regs_map_t *m, uint16_t start, app_regs_bank_t *bank)
+{
+  if (!bank || !bank->shadow) return 0;
+  const app_regs_region_t r = { .start = start, .count = 1, .txn = bank };
+  return map_add(m, APP_REGS_HR, &r);
+}
+
+const app_regs_region_t *APP_RegsMapFind(const app_regs_map_t *m, app_regs_table_t t,
+                                         uint16_t addr, uint16_t qty)
+{
+  if (!m || (uint32_t)t >= APP_REGS_TABLES || qty == 0) return NULL;
+
+  const uint8_t slot = m->page[t][addr >> APP_REGS_PAGE_SHIFT];
+  if (slot == 0) return NULL;
+
+  /* tek kontrol: tum istek araligi bu region icinde mi */
+  const app_regs_region_t *r = &m->region[t][slot - 1u];
+  if (addr < r->start || (uint32_t)addr + qty > (uint32_t)r->start + r->count) return NULL;
+  return r;
+}
+
+uint16_t APP_RegsMapRead(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint16_t* out, uint16_t qty)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, qty);
+  if (!r) return 0;
+
+  const uint16_t off = (uint16_t)(addr - r->start);
+  if (r->bank) return APP_RegsBankRead(r->bank, off, out, qty);
+  if (r->read) return r->read(off, out, qty);
+  if (r->txn) {
+    out[0] = APP_RegsBankTxnState(r->txn);
+    return qty;
+  }
+  return 0;
+}
+
+uint16_t APP_RegsMapWrite(const app_regs_map_t *m, uint8_t src, app_regs_table_t t,
+                          uint16_t addr, const uint16_t* in, uint16_t qty)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, qty);
+  if (r && r->txn) {
+    const uint16_t rc = APP_RegsBankTxnCtrl(r->txn, src, in[0]);
+    return (rc == 1u) ? qty : rc;
+  }
+  if (!r || !r->bank) return 0; /* hesaplanan region'lar read-only */
+
+  const uint16_t off = (uint16_t)(addr - r->start);
+  if (!meta_writable(r->bank, off, qty)) return 0;
+  return APP_RegsBankWrite(r->bank, src, off, in, qty);
+}
+
+uint16_t APP_RegsMapMaskWrite(const app_regs_map_t *m, uint8_t src, uint16_t addr, uint16_t and_mask, uint16_t or_mask)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, APP_REGS_HR, addr, 1);
+  if (!r || !r->bank) return 0;
+
+  const uint16_t off = (uint16_t)(addr - r->start);
+  if (!meta_writable(r->bank, off, 1)) return 0;
+  return APP_RegsBankMaskWrite(r->bank, src, off, and_mask, or_mask);
+}
+
+uint16_t APP_RegsMapReadWrite(const app_regs_map_t *m, uint8_t src,
+                              uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                              uint16_t raddr, uint16_t* out, uint16_t rqty)
+{
+  const app_regs_region_t *wr = APP_RegsMapFind(m, APP_REGS_HR, waddr, wqty);
+  const app_regs_region_t *rr = APP_RegsMapFind(m, APP_REGS_HR, raddr, rqty);
+  if (!wr || !rr || !wr->bank) return 0;
+  if (!meta_writable(wr->bank, (uint16_t)(waddr - wr->start), wqty)) return 0;
+
+  if (wr->bank == rr->bank) {
+    return APP_RegsBankReadWrite(wr->bank, src, (uint16_t)(waddr - wr->start), in, wqty,
+                                 (uint16_t)(raddr - rr->start), out, rqty);
+  }
+
+  /* farkli region: her biri kendi icinde tutarli, ikisi birlikte atomik degil */
+  const uint16_t wn = APP_RegsBankWrite(wr->bank, src, (uint16_t)(waddr - wr->start), in, wqty);
+  if (wn != wqty) return (wn == APP_REGS_BUSY) ? APP_REGS_BUSY : 0u;
+  return (APP_RegsMapRead(m, APP_REGS_HR, raddr, out, rqty) == rqty) ? 1u : 0u;
+}
+
+uint16_t APP_RegsMapReadBits(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint8_t *packed, uint16_t qty)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, qty);
+  if (!r || !r->bits) return 0;
+
+  return APP_RegsBitsRead(r->bits, (uint16_t)(addr - r->start), packed, qty);
+}
+
+uint16_t APP_RegsMapWriteBits(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, const uint8_t *packed, uint16_t qty)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, qty);
+  if (!r || !r->bits) return 0;
+
+  return APP_RegsBitsWrite(r->bits, (uint16_t)(addr - r->start), packed, qty);
+}
+
+uint16_t APP_RegsMapWriteBit(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint8_t v)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, 1);
+  if (!r || !r->bits) return 0;
+
+  return APP_RegsBitsSet(r->bits, (uint16_t)(addr - r->start), v);
+}
+
+app_regs_map_t *APP_RegsMainMap(void)
+{
+  return &g_main_map;
+}
+
+app_regs_map_t *APP_RegsZoneMap(uint8_t zone)
+{
+#if APP_MODBUS_ZONE_UNIT_COUNT > 0
+  if (zone < APP_MODBUS_ZONE_UNIT_COUNT) return &g_zone_map[zone];
+#else
+  (void)zone;
+#endif
+  return NULL;
+}
+
+app_regs_bank_t *APP_RegsMainBank(void)
+{
+  return &g_main;
+}
+
+app_regs_bank_t *APP_RegsZoneBank(uint8_t zone)
+{
+#if APP_MODBUS_ZONE_UNIT_COUNT > 0
+  if (zone < APP_MODBUS_ZONE_UNIT_COUNT) return &g_zone[zone];
+#else
+  (void)zone;
+#endif
+  return NULL;
+}
+
+/* ------------------ main bank API ------------------ */
+
+void APP_RegsInit(void)
+{
+  meta_build(s_main_meta, APP_MODBUS_HR_COUNT, s_hr_defs, sizeof(s_hr_defs) / sizeof(s_hr_defs[0]));
+  APP_RegsBankInit(&g_main, g_hr, APP_MODBUS_HR_COUNT, s_main_meta, main_on_write_locked, "hr_mutex");
+
+  g_hr[APP_HR_MINUTES]    = 0;
+  g_hr[APP_HR_SECONDS]    = 0;
+  g_hr[APP_HR_YEAR]       = 1970;
+  g_hr[APP_HR_MONTH]      = 1;
+  g_hr[APP_HR_DAY]        = 1;
+  g_hr[APP_HR_LOG_ENABLE] = 1;
+
+  memcpy(s_notify_last, g_hr, sizeof(s_notify_last));
+
+  s_sub_count = 0;
+
+  /* ana unit map'i: HR0..31 + ek region'lar (config) */
+  APP_RegsMapInit(&g_main_map);
+  (void)APP_RegsMapAddWords(&g_main_map, APP_REGS_HR, 0, &g_main);
+#if APP_REGS_TXN_ENABLE
+  APP_RegsBankEnableTxn(&g_main, g_hr_shadow);
+  (void)APP_RegsMapAddTxn(&g_main_map, APP_REGS_TXN_CTRL_ADDR, &g_main);
+#endif
+
+#if APP_REGS_HR_EXT_COUNT > 0
+  APP_RegsBankInit(&g_hr_ext_bank, g_hr_ext, APP_REGS_HR_EXT_COUNT, NULL, NULL, "hr_ext_mutex");
+  (void)APP_RegsMapAddWords(&g_main_map, APP_REGS_HR, APP_REGS_HR_EXT_BASE, &g_hr_ext_bank);
+#endif
+#if APP_REGS_IR_COUNT > 0
+  APP_RegsBankInit(&g_ir_bank, g_ir, APP_REGS_IR_COUNT, NULL, NULL, "ir_mutex");
+  (void)APP_RegsMapAddWords(&g_main_map, APP_REGS_IR, APP_REGS_IR_BASE, &g_ir_bank);
+#endif
+#if APP_REGS_COIL_COUNT > 0
+  APP_RegsBitsInit(&g_coil_bits, g_coil, APP_REGS_COIL_COUNT);
+  (void)APP_RegsMapAddBits(&g_main_map, APP_REGS_COIL, APP_REGS_COIL_BASE, &g_coil_bits);
+#endif
+#if APP_REGS_DI_COUNT > 0
+  APP_RegsBitsInit(&g_di_bits, g_di, APP_REGS_DI_COUNT);
+  (void)APP_RegsMapAddBits(&g_main_map, APP_REGS_DI, APP_REGS_DI_BASE, &g_di_bits);
+#endif
+
+#if APP_MODBUS_ZONE_UNIT_COUNT > 0
+  for (uint8_t i = 0; i < APP_MODBUS_ZONE_UNIT_COUNT; ++i) {
+    APP_RegsBankInit(&g_zone[i], g_zone_hr[i], APP_MODBUS_ZONE_HR_COUNT, NULL, NULL, "zone_mutex");
+    APP_RegsMapInit(&g_zone_map[i]);
+    (void)APP_RegsMapAddWords(&g_zone_map[i], APP_REGS_HR, 0, &g_zone[i]);
+  }
+#endif
+}
+
+void APP_RegsTick(void)
+{
+  APP_RegsBankTick(&g_main);
+}
+
+void APP_RegsTxnRelease(uint8_t src)
+{
+  APP_RegsBankTxnRelease(&g_main, src);
+}
+
+uint16_t APP_RegsReadHR(uint16_t addr)
+{
+  if (!valid_range(&g_main, addr, 1)) return 0;
+
+  uint16_t v;
+  seq_read(&g_main, addr, &v, 1);
+  return v;
+}
+
+uint16_t APP_RegsReadHRBlock(uint16_t addr, uint16_t* out, uint16_t qty)
+{
+  return APP_RegsBankRead(&g_main, addr, out, qty);
+}
+
+uint16_t APP_RegsWriteHR(uint16_t addr, uint16_t value)
+{
+  return APP_RegsBankWrite(&g_main, APP_REGS_SRC_LOCAL, addr, &value, 1);
+}
+
+uint16_t APP_RegsWriteHRBlock(uint16_t addr, const uint16_t* in, uint16_t qty)
+{
+  return APP_RegsBankWrite(&g_main, APP_REGS_SRC_LOCAL, addr, in, qty);
+}
+
+uint16_t APP_RegsReadWriteHRBlock(uint16_t waddr, const uint16_t* in, uint16_t wqty,
+                                  uint16_t raddr, uint16_t* out, uint16_t rqty)
+{
+  return APP_RegsBankReadWrite(&g_main, APP_REGS_SRC_LOCAL, waddr, in, wqty, raddr, out, rqty);
+}
+
+uint16_t APP_RegsMaskWriteHR(uint16_t addr, uint16_t and_mask, uint16_t or_mask)
+{
+  return APP_RegsBankMaskWrite(&g_main, APP_REGS_SRC_LOCAL, addr, and_mask, or_mask);
+}
+
+/* MMM/SS, tarih ve LOG_ENABLE bitisik: tek seq okuma ile tutarli snapshot */
 void APP_RegsGetTime(uint16_t* minutes, uint16_t* seconds)
 {
   if (!minutes || !seconds) return;
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
-  *minutes = g_hr[APP_HR_MINUTES];
-  *seconds = g_hr[APP_HR_SECONDS];
-  osMutexRelease(g_hr_mutex);
+  uint16_t v[2];
+  seq_read(&g_main, APP_HR_MINUTES, v, 2);
+  *minutes = v[0];
+  *seconds = v[1];
 }
 
 void APP_RegsGetDate(uint16_t* year, uint16_t* month, uint16_t* day)
 {
   if (!year || !month || !day) return;
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
-  *year  = g_hr[APP_HR_YEAR];
-  *month = g_hr[APP_HR_MONTH];
-  *day   = g_hr[APP_HR_DAY];
-  osMutexRelease(g_hr_mutex);
+  uint16_t v[3];
+  seq_read(&g_main, APP_HR_YEAR, v, 3);
+  *year  = v[0];
+  *month = v[1];
+  *day   = v[2];
 }
 
 uint8_t APP_RegsGetLogEnable(void)
 {
-  osMutexAcquire(g_hr_mutex, osWaitForever);
-  uint16_t v = g_hr[APP_HR_LOG_ENABLE];
-  osMutexRelease(g_hr_mutex);
+  uint16_t v;
+  seq_read(&g_main, APP_HR_LOG_ENABLE, &v, 1);
   return (v != 0);
 }
 
-bool APP_RegsConsumeChangedTime(uint16_t *mmm, uint16_t *ss)
+const char *APP_RegsMetaCsv(uint32_t *len)
+{
+  if (len) *len = (uint32_t)(sizeof(s_hr_csv) - 1u);
+  return s_hr_csv;
+}
+
+const app_regs_meta_t *APP_RegsMetaGet(uint16_t addr)
+{
+  return (addr < APP_MODBUS_HR_COUNT) ? &s_main_meta[addr] : NULL;
+}
+
+void APP_RegsRetainMask(uint32_t *mask)
+{
+  memset(mask, 0, APP_REGS_HR_WORDS * sizeof(uint32_t));
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (s_main_meta[a].retain == APP_REGS_R_RET) mask[a >> 5] |= 1u << (a & 31u);
+  }
+}
+
+/* ------------------ typed views ------------------ */
+
+/*
+ * BE: w[0] en anlamli word (ABCD)
+ * WS: w[n-1] en anlamli word, word ici byte sirasi ayni (CDAB)
+ * LE: WS + word ici byte swap (DCBA)
+ */
+uint64_t APP_RegsWordsToU64(const uint16_t *w, uint8_t nwords, uint8_t order)
+{
+  uint64_t v = 0;
+  for (uint8_t k = 0; k < nwords; ++k) {
+    if (order == APP_REGS_WO_BE) {
+      v = (v << 16) | w[k];
+    } else {
+      const uint16_t x = (order == APP_REGS_WO_LE) ? __REV16(w[k]) : w[k];
+      v |= (uint64_t)x << (16u * k);
+    }
+  }
+  return v;
+}
+
+void APP_RegsU64ToWords(uint64_t v, uint16_t *w, uint8_t nwords, uint8_t order)
+{
+  for (uint8_t k = 0; k < nwords; ++k) {
+    if (order == APP_REGS_WO_BE) {
+      w[nwords - 1u - k] = (uint16_t)(v >> (16u * k));
+    } else {
+      const uint16_t x = (uint16_t)(v >> (16u * k));
+      w[k] = (order == APP_REGS_WO_LE) ? (uint16_t)__REV16(x) : x;
+    }
+  }
+}
+
+static uint8_t typed_get(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr,
+                         uint8_t nwords, uint64_t *out)
+{
+  uint16_t w[4];
+  if (!m || !out) return 0;
+  if (APP_RegsMapRead(m, t, addr, w, nwords) != nwords) return 0; /* tek seq okuma */
+  *out = APP_RegsWordsToU64(w, nwords, m->word_order);
+  return 1;
+}
+
+static uint8_t typed_set(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr,
+                         uint8_t nwords, uint64_t v)
+{
+  const app_regs_region_t *r = APP_RegsMapFind(m, t, addr, nwords);
+  if (!r || !r->bank) return 0;
+
+  uint16_t w[4];
+  APP_RegsU64ToWords(v, w, nwords, m->word_order);
+  return (APP_RegsBankWrite(r->bank, APP_REGS_SRC_LOCAL, (uint16_t)(addr - r->start), w, nwords) == nwords); /* tek seq yazma */
+}
+
+uint8_t APP_RegsMapGetU32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint32_t *out)
 {
-  bool changed = false;
+  uint64_t v;
+  if (!out || !typed_get(m, t, addr, 2, &v)) return 0;
+  *out = (uint32_t)v;
+  return 1;
+}
+
+uint8_t APP_RegsMapSetU32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint32_t v)
+{
+  return typed_set(m, t, addr, 2, v);
+}
+
+uint8_t APP_RegsMapGetF32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, float *out)
+{
+  uint32_t u;
+  if (!out || !APP_RegsMapGetU32(m, t, addr, &u)) return 0;
+  memcpy(out, &u, sizeof(*out));
+  return 1;
+}
+
+uint8_t APP_RegsMapSetF32(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, float v)
+{
+  uint32_t u;
+  memcpy(&u, &v, sizeof(u));
+  return typed_set(m, t, addr, 2, u);
+}
 
-  osMutexAcquire(g_hr_mutex, osWaitForever);
+uint8_t APP_RegsMapGetU64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint64_t *out)
+{
+  return typed_get(m, t, addr, 4, out);
+}
 
-  const uint16_t m = g_hr[APP_HR_MINUTES];
-  const uint16_t s = g_hr[APP_HR_SECONDS];
+uint8_t APP_RegsMapSetU64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, uint64_t v)
+{
+  return typed_set(m, t, addr, 4, v);
+}
 
-  if (s_time_dirty || m != s_last_m || s != s_last_s) {
-    s_time_dirty = 0;
-    s_last_m = m;
-    s_last_s = s;
+uint8_t APP_RegsMapGetF64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, double *out)
+{
+  uint64_t u;
+  if (!out || !typed_get(m, t, addr, 4, &u)) return 0;
+  memcpy(out, &u, sizeof(*out));
+  return 1;
+}
 
-    if (mmm) *mmm = m;
-    if (ss)  *ss  = s;
+uint8_t APP_RegsMapSetF64(const app_regs_map_t *m, app_regs_table_t t, uint16_t addr, double v)
+{
+  uint64_t u;
+  memcpy(&u, &v, sizeof(u));
+  return typed_set(m, t, addr, 4, u);
+}
 
-    changed = true;
+uint32_t APP_RegsGetU32(uint16_t addr)
+{
+  uint32_t v = 0;
+  (void)APP_RegsMapGetU32(&g_main_map, APP_REGS_HR, addr, &v);
+  return v;
+}
+
+int32_t APP_RegsGetI32(uint16_t addr)
+{
+  return (int32_t)APP_RegsGetU32(addr);
+}
+
+float APP_RegsGetF32(uint16_t addr)
+{
+  float v = 0.0f;
+  (void)APP_RegsMapGetF32(&g_main_map, APP_REGS_HR, addr, &v);
+  return v;
+}
+
+/* ------------------ change notification ------------------ */
+
+int8_t APP_RegsSubscribe(uint32_t flag, const uint32_t *watch)
+{
+  if (!watch || flag == 0) return -1;
+
+  int8_t id = -1;
+  osMutexAcquire(g_main.mutex, osWaitForever); /* writer'larla serilesir */
+  if (s_sub_count < APP_REGS_MAX_SUBS) {
+    chg_sub_t *sub = &s_sub[s_sub_count];
+    sub->task = osThreadGetId();
+    sub->flag = flag;
+    memcpy(sub->watch, watch, sizeof(sub->watch));
+    memset(sub->dirty, 0, sizeof(sub->dirty));
+    id = (int8_t)s_sub_count++;
+  }
+  osMutexRelease(g_main.mutex);
+  return id;
+}
+
+int8_t APP_RegsSubscribeHook(uint32_t flag, uint8_t hook)
+{
+  uint32_t watch[APP_REGS_HR_WORDS] = { 0 };
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (s_main_meta[a].hook == hook) watch[a >> 5] |= 1u << (a & 31u);
   }
+  return APP_RegsSubscribe(flag, watch);
+}
 
-  osMutexRelease(g_hr_mutex);
-  return changed;
+uint8_t APP_RegsTakeChanges(int8_t id, uint32_t *changed)
+{
+  if (id < 0 || (uint8_t)id >= s_sub_count) return 0;
+
+  uint32_t any = 0;
+  for (uint32_t w = 0; w < APP_REGS_HR_WORDS; ++w) {
+    const uint32_t v = __atomic_exchange_n(&s_sub[id].dirty[w], 0u, __ATOMIC_ACQUIRE);
+    if (changed) changed[w] = v;
+    any |= v;
+  }
+  return (any != 0);
 }
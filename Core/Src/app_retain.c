@@ -0,0 +1,379 @@
+#include "app_retain.h"
+#include "app_retain_flash.h"
+#include "app_regs.h"
+#include "app_config.h"
+
+#if APP_RETAIN_ENABLE
+
+#include "cmsis_os.h"
+
+#include "stm32f4xx_hal.h"
+
+#include <string.h>
+
+/*
+ * Retentive holding register'lar (APP_HR_TABLE ret = RET).
+ *
+ * Backup SRAM (4 KB, VBAT ile korunur): HR imaji + layout + checksum. Her degisiklik
+ * olayinda guncellenir (birkac us); reset sonrasi ilk tercih.
+ *
+ * Flash (VBAT yoksa): iki sektor ping-pong, log-structured. Her record tek 32-bit word
+ * (check + adres + deger); flush'ta sadece degisen register'lar eklenir. Sektor dolunca
+ * diger sektor silinip guncel degerler yazilir (compaction), header en son yazilir:
+ * yarida kalan compaction eski sektoru gecerli birakir.
+ *
+ * Coalescing: ilk degisiklikten APP_RETAIN_FLASH_DELAY_MS sonra tek flush; aradaki
+ * FC16 patlamasi tek program oturumu ve register basina en fazla bir record olur.
+ * Program/erase app_retain_flash.c uzerinden (BSY beklemesi RAM'de); basarisiz flush
+ * pending kalir ve sonraki deneme temiz sektore compaction ile yazar.
+ */
+
+#define RET_BKP_MAGIC 0x52544E31u /* "RTN1" */
+
+typedef struct {
+  uint32_t magic;
+  uint32_t layout;
+  uint16_t hr[APP_MODBUS_HR_COUNT]; /* retentive olmayanlar 0 */
+  uint32_t sum;
+} ret_bkp_t;
+
+_Static_assert(sizeof(ret_bkp_t) <= 4096u, "ret_bkp_t backup SRAM'e sigmiyor");
+
+#define RET_BKP ((volatile ret_bkp_t *)BKPSRAM_BASE)
+
+#define FNV_INIT 2166136261u
+
+static uint32_t s_mask[APP_REGS_HR_WORDS];
+static uint32_t s_layout;
+static app_retain_stats_t s_stats;
+
+static inline uint8_t is_ret(uint16_t a)
+{
+  return (uint8_t)((s_mask[a >> 5] >> (a & 31u)) & 1u);
+}
+
+static uint32_t fnv1a(uint32_t h, const void *p, uint32_t n)
+{
+  const uint8_t *b = (const uint8_t *)p;
+  for (uint32_t i = 0; i < n; ++i) {
+    h ^= b[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* Retentive adres kumesi degisirse (APP_HR_TABLE) eski kopyalar yok sayilir */
+static uint32_t layout_hash(void)
+{
+  const uint32_t n = APP_MODBUS_HR_COUNT;
+  return fnv1a(fnv1a(FNV_INIT, &n, sizeof(n)), s_mask, sizeof(s_mask));
+}
+
+/* ------------------ backup SRAM ------------------ */
+
+static void bkp_enable(void)
+{
+  __HAL_RCC_PWR_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+  __HAL_RCC_BKPSRAM_CLK_ENABLE();
+  (void)HAL_PWREx_EnableBkUpReg(); /* backup regulator: VBAT'ta da icerik korunur */
+}
+
+static uint32_t bkp_sum(const uint16_t *img)
+{
+  return fnv1a(s_layout, img, APP_MODBUS_HR_COUNT * sizeof(uint16_t));
+}
+
+/* Gecerliyse retentive word'leri hr'ye yaz. 1 = OK */
+static uint8_t bkp_load(uint16_t *hr)
+{
+  volatile ret_bkp_t *b = RET_BKP;
+  if (b->magic != RET_BKP_MAGIC || b->layout != s_layout) return 0;
+
+  uint16_t img[APP_MODBUS_HR_COUNT];
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) img[a] = b->hr[a];
+  if (bkp_sum(img) != b->sum) return 0;
+
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (is_ret(a)) hr[a] = img[a];
+  }
+  return 1;
+}
+
+/* Araya reset girerse sum tutmaz -> boot'ta flash kopyasi kullanilir */
+static void bkp_store(const uint16_t *hr)
+{
+  volatile ret_bkp_t *b = RET_BKP;
+  uint16_t img[APP_MODBUS_HR_COUNT];
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) img[a] = is_ret(a) ? hr[a] : 0u;
+
+  b->magic  = RET_BKP_MAGIC;
+  b->layout = s_layout;
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) b->hr[a] = img[a];
+  b->sum    = bkp_sum(img);
+}
+
+/* ------------------ flash log ------------------ */
+
+#if APP_RETAIN_FLASH_ENABLE
+
+#define RET_FL_WORDS  (APP_RETAIN_FLASH_SIZE / 4u)
+#define RET_FL_HDR    2u          /* [0] generation (en son yazilir), [1] layout */
+#define RET_FL_ERASED 0xFFFFFFFFu
+#define RET_FL_NONE   0xFFu
+
+_Static_assert(APP_MODBUS_HR_COUNT < 255u, "record adresi 8 bit");
+_Static_assert(RET_FL_HDR + APP_MODBUS_HR_COUNT < RET_FL_WORDS, "retain sektoru kucuk");
+_Static_assert(APP_RETAIN_FLASH_ERASE_MAX_MS * 4u < APP_WDG_TIMEOUT_MS, "sektor silme watchdog'a yakin");
+
+static const uint32_t s_fl_addr[2]   = { APP_RETAIN_FLASH_ADDR_A, APP_RETAIN_FLASH_ADDR_B };
+static const uint32_t s_fl_sector[2] = { APP_RETAIN_FLASH_SECTOR_A, APP_RETAIN_FLASH_SECTOR_B };
+
+static uint8_t  s_fl_active = RET_FL_NONE; /* gecerli sektor (0/1) */
+static uint32_t s_fl_gen;
+static uint32_t s_fl_wp;                   /* aktif sektorde ilk bos word */
+static uint16_t s_fl_val[APP_MODBUS_HR_COUNT];
+static uint32_t s_fl_have[APP_REGS_HR_WORDS]; /* flash'ta record'u olan adresler */
+
+static inline uint32_t fl_word(uint8_t s, uint32_t i)
+{
+  return APP_RetainFlRead(s_fl_addr[s] + i * 4u);
+}
+
+/* record: [31:24] check, [23:16] adres, [15:0] deger. Silinmis word hicbir zaman gecerli degil */
+static inline uint8_t rec_check(uint8_t a, uint16_t v)
+{
+  return (uint8_t)~(a ^ (uint8_t)v ^ (uint8_t)(v >> 8));
+}
+
+static inline uint32_t rec_make(uint16_t a, uint16_t v)
+{
+  return ((uint32_t)rec_check((uint8_t)a, v) << 24) | ((uint32_t)a << 16) | v;
+}
+
+static uint8_t rec_parse(uint32_t r, uint16_t *a, uint16_t *v)
+{
+  const uint8_t  ra = (uint8_t)(r >> 16);
+  const uint16_t rv = (uint16_t)r;
+  if ((uint8_t)(r >> 24) != rec_check(ra, rv) || ra >= APP_MODBUS_HR_COUNT) return 0;
+  *a = ra;
+  *v = rv;
+  return 1;
+}
+
+static inline void fl_set(uint16_t a, uint16_t v)
+{
+  s_fl_val[a] = v;
+  s_fl_have[a >> 5] |= 1u << (a & 31u);
+}
+
+static inline uint8_t fl_stale(uint16_t a, uint16_t v)
+{
+  return !((s_fl_have[a >> 5] >> (a & 31u)) & 1u) || s_fl_val[a] != v;
+}
+
+/* Boot: en yeni gecerli sektoru bul, record'lari sirayla uygula (son yazilan kazanir) */
+static void fl_scan(void)
+{
+  s_fl_active = RET_FL_NONE;
+  s_fl_gen = 0;
+  memset(s_fl_have, 0, sizeof(s_fl_have));
+
+  for (uint8_t s = 0; s < 2u; ++s) {
+    const uint32_t gen = fl_word(s, 0);
+    if (gen == RET_FL_ERASED || fl_word(s, 1) != s_layout) continue;
+    if (s_fl_active == RET_FL_NONE || gen > s_fl_gen) {
+      s_fl_active = s;
+      s_fl_gen = gen;
+    }
+  }
+  if (s_fl_active == RET_FL_NONE) return;
+
+  uint32_t i = RET_FL_HDR;
+  for (; i < RET_FL_WORDS; ++i) {
+    const uint32_t r = fl_word(s_fl_active, i);
+    if (r == RET_FL_ERASED) break;
+
+    uint16_t a, v;
+    if (rec_parse(r, &a, &v) && is_ret(a)) fl_set(a, v); /* yarim program edilmis word atlanir */
+  }
+  s_fl_wp = i;
+}
+
+static uint8_t fl_program(uint8_t s, uint32_t i, uint32_t w)
+{
+  if (!APP_RetainFlProgram(s_fl_addr[s] + i * 4u, w)) return 0;
+  s_stats.words++;
+  return 1;
+}
+
+/* Sistem geneli stall: sure DWT ile olculur (SysTick bu sirada kacirilir) */
+static uint8_t fl_erase(uint8_t s)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  const uint8_t ok = APP_RetainFlErase(s_fl_sector[s]);
+  const uint32_t us = (DWT->CYCCNT - t0) / (SystemCoreClock / 1000000u);
+  if (us > s_stats.erase_max_us) s_stats.erase_max_us = us;
+  if (!ok) return 0;
+  s_stats.erases++;
+  return 1;
+}
+
+/* Diger sektoru sil, guncel degerleri yaz, header'i en son yaz */
+static uint8_t fl_compact(const uint16_t *hr)
+{
+  const uint8_t s = (s_fl_active == 0u) ? 1u : 0u;
+  if (!fl_erase(s)) return 0;
+
+  uint32_t i = RET_FL_HDR;
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (is_ret(a) && !fl_program(s, i++, rec_make(a, hr[a]))) return 0;
+  }
+  if (!fl_program(s, 1, s_layout)) return 0;
+  if (!fl_program(s, 0, s_fl_gen + 1u)) return 0;
+
+  s_fl_active = s;
+  s_fl_gen++;
+  s_fl_wp = i;
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (is_ret(a)) fl_set(a, hr[a]);
+  }
+  return 1;
+}
+
+/* Flash'takinden farkli retentive register'lar icin record ekle (tek program oturumu).
+ * Donus: 1 = flash guncel, 0 = program/erase hatasi (cagiran pending tutar) */
+static uint8_t fl_flush(const uint16_t *hr)
+{
+  uint32_t n = 0;
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+    if (is_ret(a) && fl_stale(a, hr[a])) n++;
+  }
+  if (n == 0) return 1;
+
+  uint8_t ok = 1;
+  APP_RetainFlUnlock();
+  if (s_fl_active == RET_FL_NONE || s_fl_wp + n > RET_FL_WORDS) {
+    ok = fl_compact(hr);
+  } else {
+    for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+      if (!is_ret(a) || !fl_stale(a, hr[a])) continue;
+      const uint32_t i = s_fl_wp++; /* hata olsa da word kullanilmis sayilir */
+      if (!fl_program(s_fl_active, i, rec_make(a, hr[a]))) {
+        /* yarim programlanmis word'un uzerine yazilamaz: tekrar deneme compaction ile */
+        s_fl_wp = RET_FL_WORDS;
+        ok = 0;
+        break;
+      }
+      fl_set(a, hr[a]);
+    }
+  }
+  APP_RetainFlLock();
+  if (ok) {
+    s_stats.flushes++;
+  } else {
+    s_stats.errors++;
+  }
+  return ok;
+}
+
+#endif /* APP_RETAIN_FLASH_ENABLE */
+
+/* ------------------ public ------------------ */
+
+/* Ardisik retentive register'lar tek blok yazmasiyla (aradaki volatile payload'a dokunmaz) */
+static void restore_runs(const uint16_t *hr)
+{
+  uint16_t a = 0;
+  while (a < APP_MODBUS_HR_COUNT) {
+    if (!is_ret(a)) { a++; continue; }
+
+    const uint16_t a0 = a;
+    while (a < APP_MODBUS_HR_COUNT && is_ret(a)) a++;
+    (void)APP_RegsWriteHRBlock(a0, &hr[a0], (uint16_t)(a - a0));
+  }
+}
+
+void APP_RetainInit(void)
+{
+  memset(&s_stats, 0, sizeof(s_stats));
+  APP_RegsRetainMask(s_mask);
+  s_layout = layout_hash();
+  bkp_enable();
+
+  uint16_t hr[APP_MODBUS_HR_COUNT];
+  (void)APP_RegsReadHRBlock(0, hr, APP_MODBUS_HR_COUNT); /* varsayilanlar */
+
+#if APP_RETAIN_FLASH_ENABLE
+  fl_scan();
+#endif
+
+  if (bkp_load(hr)) {
+    s_stats.source = APP_RETAIN_SRC_BKPSRAM;
+  }
+#if APP_RETAIN_FLASH_ENABLE
+  else if (s_fl_active != RET_FL_NONE) {
+    for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) {
+      if (is_ret(a) && ((s_fl_have[a >> 5] >> (a & 31u)) & 1u)) hr[a] = s_fl_val[a];
+    }
+    s_stats.source = APP_RETAIN_SRC_FLASH;
+  }
+#endif
+
+  if (s_stats.source != APP_RETAIN_SRC_DEFAULT) restore_runs(hr);
+
+  /* clamp sonrasi degerler */
+  (void)APP_RegsReadHRBlock(0, hr, APP_MODBUS_HR_COUNT);
+  bkp_store(hr);
+}
+
+void APP_RetainTask(void *argument)
+{
+  (void)argument;
+
+  const int8_t sub = APP_RegsSubscribe(APP_REGS_NOTIFY_FLAG, s_mask);
+  uint16_t hr[APP_MODBUS_HR_COUNT];
+
+  /* boot: flash backup SRAM'in gerisinde olabilir -> ilk flush'ta esitlenir */
+  uint8_t  pending = APP_RETAIN_FLASH_ENABLE;
+  uint32_t t_first = osKernelGetTickCount();
+
+  for (;;) {
+    uint32_t wait = (sub < 0) ? APP_RETAIN_FLASH_DELAY_MS : osWaitForever;
+    if (pending) {
+      const uint32_t age = osKernelGetTickCount() - t_first;
+      wait = (age >= APP_RETAIN_FLASH_DELAY_MS) ? 0u : (APP_RETAIN_FLASH_DELAY_MS - age);
+    }
+    (void)osThreadFlagsWait(APP_REGS_NOTIFY_FLAG, osFlagsWaitAny, wait);
+
+    if (sub < 0 || APP_RegsTakeChanges(sub, NULL)) {
+      (void)APP_RegsReadHRBlock(0, hr, APP_MODBUS_HR_COUNT);
+      bkp_store(hr);
+      s_stats.changes++;
+      if (!pending) {
+        pending = APP_RETAIN_FLASH_ENABLE;
+        t_first = osKernelGetTickCount();
+      }
+    }
+
+#if APP_RETAIN_FLASH_ENABLE
+    if (pending && (osKernelGetTickCount() - t_first) >= APP_RETAIN_FLASH_DELAY_MS) {
+      (void)APP_RegsReadHRBlock(0, hr, APP_MODBUS_HR_COUNT);
+      if (fl_flush(hr)) {
+        pending = 0;
+      } else {
+        t_first = osKernelGetTickCount(); /* hata: bir gecikme sonra tekrar */
+      }
+    }
+#endif
+  }
+}
+
+uint8_t APP_RetainGetStats(app_retain_stats_t *out)
+{
+  if (!out) return 0;
+  *out = s_stats;
+  return 1;
+}
+
+#endif /* APP_RETAIN_ENABLE */
@@ -0,0 +1,92 @@
+#include "app_retain_flash.h"
+#include "app_config.h"
+
+#if APP_RETAIN_ENABLE && APP_RETAIN_FLASH_ENABLE
+
+#include "stm32f4xx_hal.h"
+
+#include <stddef.h>
+
+/*
+ * Retain sektorleri icin register-level program/erase.
+ *
+ * F407 tek bank: BSY suresince flash'tan instruction/literal fetch eden her sey bekler.
+ * Komutu baslatip BSY'yi bekleyen dongu RAM'de (.RamFunc, ST'nin __RAM_FUNC'i) calisir;
+ * boylece retain task'in kendisi flash'a dokunmaz ve IRQ'lar acik kalir. Flash'tan
+ * calisan ISR/task'lar yine de komut bitene kadar durur: sure sinirlari ve siklik
+ * app_config.h'de (APP_RETAIN_FLASH_*), olculen en kotu erase suresi stats'ta.
+ * HAL_FLASHEx_Erase / HAL_FLASH_Program flash'ta kosar ve sure boyunca BSY polling'i
+ * flash'tan fetch eder; o yuzden burada kullanilmaz.
+ */
+
+#define FL_SR_ERR (FLASH_SR_OPERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR)
+
+/* RAM'de: cr'yi yaz, (program ise) word'u yaz, BSY bitene kadar bekle. Donus: SR */
+static __RAM_FUNC __attribute__((noinline)) uint32_t fl_ram_exec(uint32_t cr, volatile uint32_t *dst, uint32_t w)
+{
+  FLASH->CR = cr;
+  if (dst) {
+    *dst = w;
+  } else {
+    FLASH->CR = cr | FLASH_CR_STRT;
+  }
+  __DSB();
+  while (FLASH->SR & FLASH_SR_BSY) { }
+  const uint32_t sr = FLASH->SR;
+  FLASH->CR = cr & ~(FLASH_CR_PG | FLASH_CR_SER | FLASH_CR_SNB);
+  return sr;
+}
+
+/* Data cache silinmis/programlanmis sektorun eski icerigini tutabilir (HAL FLASH_FlushCaches gibi) */
+static void fl_dcache_reset(void)
+{
+  if (FLASH->ACR & FLASH_ACR_DCEN) {
+    FLASH->ACR &= ~FLASH_ACR_DCEN;
+    FLASH->ACR |= FLASH_ACR_DCRST;
+    FLASH->ACR &= ~FLASH_ACR_DCRST;
+    FLASH->ACR |= FLASH_ACR_DCEN;
+  }
+}
+
+void APP_RetainFlUnlock(void)
+{
+  (void)HAL_FLASH_Unlock();
+  FLASH->SR = FL_SR_ERR | FLASH_SR_EOP; /* onceki hatalar (w1c) */
+}
+
+void APP_RetainFlLock(void)
+{
+  (void)HAL_FLASH_Lock();
+}
+
+uint32_t APP_RetainFlRead(uint32_t addr)
+{
+  return *(const volatile uint32_t *)addr;
+}
+
+uint8_t APP_RetainFlProgram(uint32_t addr, uint32_t w)
+{
+  const uint32_t cr = (FLASH->CR & ~(FLASH_CR_PSIZE | FLASH_CR_SNB | FLASH_CR_SER)) | FLASH_PSIZE_WORD | FLASH_CR_PG;
+  const uint32_t sr = fl_ram_exec(cr, (volatile uint32_t *)addr, w);
+  fl_dcache_reset();
+  if (sr & FL_SR_ERR) {
+    FLASH->SR = sr & FL_SR_ERR;
+    return 0;
+  }
+  return 1;
+}
+
+uint8_t APP_RetainFlErase(uint32_t sector)
+{
+  const uint32_t cr = (FLASH->CR & ~(FLASH_CR_PSIZE | FLASH_CR_SNB | FLASH_CR_PG)) | FLASH_PSIZE_WORD |
+                      FLASH_CR_SER | ((sector << FLASH_CR_SNB_Pos) & FLASH_CR_SNB);
+  const uint32_t sr = fl_ram_exec(cr, NULL, 0);
+  fl_dcache_reset();
+  if (sr & FL_SR_ERR) {
+    FLASH->SR = sr & FL_SR_ERR;
+    return 0;
+  }
+  return 1;
+}
+
+#endif /* APP_RETAIN_ENABLE && APP_RETAIN_FLASH_ENABLE */
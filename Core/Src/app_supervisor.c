@@ -2,6 +2,8 @@
 #include "cmsis_os.h"
 #include "app_config.h"
 #include "app_watchdog.h"
+#include "app_regs.h"
+#include "app_metrics.h"
 
 static uint32_t g_last_kick[APP_KICK_MAX];
 
@@ -34,6 +36,11 @@ void APP_SupervisorTask(void *argument)
       APP_WdgKick();
     }
 
+    APP_RegsTick();
+#if APP_METRICS_ENABLE
+    APP_MetricsSample();
+#endif
+
     osDelay(250);
   }
 }
@@ -4,15 +4,31 @@
 #include "app_modbus.h"
 #include "app_log.h"
 #include "app_p10.h"
+#include "app_retain.h"
+#include "app_metrics.h"
 #include "app_supervisor.h"
 #include "app_watchdog.h"
+#include "main.h"
 
 #include "cmsis_os.h"
 
 static osThreadId_t g_modbus_task;
 static osThreadId_t g_log_task;
+static osThreadId_t g_logwr_task;
 static osThreadId_t g_p10_task;
 static osThreadId_t g_sup_task;
+#if APP_RETAIN_ENABLE
+static osThreadId_t g_retain_task;
+#endif
+
+/* Task olusturulamazsa (heap yetmedi) eksik task'la calismak yerine dur: watchdog zaten
+ * basladi, IWDG reset'i ile boot tekrarlanir ve hata sessizce kaybolmaz. */
+static osThreadId_t sys_thread(osThreadFunc_t fn, const osThreadAttr_t *attr)
+{
+  osThreadId_t id = osThreadNew(fn, NULL, attr);
+  if (id == NULL) Error_Handler();
+  return id;
+}
 
 void APP_SystemEarlyInit(void)
 {
@@ -27,25 +43,49 @@ void APP_SystemStart(void)
 {
   /* Init shared state */
   APP_RegsInit();
+#if APP_RETAIN_ENABLE
+  APP_RetainInit(); /* retentive HR'ler, log/P10 ilk okumasindan once */
+#endif
+#if APP_METRICS_ENABLE
+  APP_MetricsInit();
+#endif
   APP_LogInit();
   APP_SupervisorInit();
 
   /* Start watchdog */
   APP_WdgInit(APP_WDG_TIMEOUT_MS);
 
+  /*
+   * Heap butcesi (configTOTAL_HEAP_SIZE 32768, heap_4; stack_size byte):
+   *   app task stack'leri 3072+1024+1536+1024+768+1024      = 8448
+   *   defaultTask 512, tcpip 2048, EthIf 350, EthLink 1024   = 3934
+   *   10 TCB (newlib reent dahil), lwIP mbox/sem/mutex, app mutex/queue ~ 4 KB
+   * Toplam ~16.5 KB: eski 15360 pay birakmiyordu, 32768 ile ~16 KB bos kalir
+   * (baglanti basina netconn mbox/sem, FatFs sync nesnesi). En dusuk bos heap metrics'te
+   * (heap_min) izlenir; 4 KB'in altina dustuyse bu butce gozden gecirilmeli.
+   */
+
   /* Modbus Task Stack: 3072 (LwIP + local bufferlar için şart) */
   const osThreadAttr_t modbus_attr = { .name = "modbus", .stack_size = 3072, .priority = (osPriority_t)osPriorityAboveNormal };
-  const osThreadAttr_t log_attr    = { .name = "log",    .stack_size = 1536, .priority = (osPriority_t)osPriorityNormal };
+  const osThreadAttr_t log_attr    = { .name = "log",    .stack_size = 1024, .priority = (osPriority_t)osPriorityNormal };
+  const osThreadAttr_t logwr_attr  = { .name = "logwr",  .stack_size = 1536, .priority = (osPriority_t)osPriorityBelowNormal };
   const osThreadAttr_t p10_attr    = { .name = "p10",    .stack_size = 1024, .priority = (osPriority_t)osPriorityHigh };
   const osThreadAttr_t sup_attr    = { .name = "sup",    .stack_size = 768,  .priority = (osPriority_t)osPriorityAboveNormal };
 
-  g_modbus_task = osThreadNew(APP_ModbusTask, NULL, &modbus_attr);
-  g_log_task    = osThreadNew(APP_LogTask, NULL, &log_attr);
-  g_p10_task    = osThreadNew(APP_P10_Task, NULL, &p10_attr);
-  g_sup_task    = osThreadNew(APP_SupervisorTask, NULL, &sup_attr);
+  g_modbus_task = sys_thread(APP_ModbusTask, &modbus_attr);
+  g_log_task    = sys_thread(APP_LogTask, &log_attr);
+  g_logwr_task  = sys_thread(APP_LogWriterTask, &logwr_attr);
+  g_p10_task    = sys_thread(APP_P10_Task, &p10_attr);
+  g_sup_task    = sys_thread(APP_SupervisorTask, &sup_attr);
+#if APP_RETAIN_ENABLE
+  const osThreadAttr_t retain_attr = { .name = "retain", .stack_size = 1024, .priority = (osPriority_t)osPriorityBelowNormal };
+  g_retain_task = sys_thread(APP_RetainTask, &retain_attr);
+  (void)g_retain_task;
+#endif
 
   (void)g_modbus_task;
   (void)g_log_task;
+  (void)g_logwr_task;
   (void)g_p10_task;
   (void)g_sup_task;
 }
@@ -26,6 +26,7 @@
 /* USER CODE BEGIN Includes */
 #include "app_system.h"
 #include "app_p10.h"
+#include "app_log.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -258,10 +259,11 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     return;
   }
 
-  /* TIM7 = P10 scan */
+  /* TIM7 = P10 scan + log sampler tick */
   if (htim->Instance == TIM7)
   {
     APP_P10_ScanISR();
+    APP_LogSamplerTickISR(); /* sampler zaman tabani (TIM7 / APP_LOG_SMP_TICK_HZ) */
     return;
   }
 }
@@ -84,7 +84,7 @@ See BSP_SD_ErrorCallback() and BSP_SD_AbortCallback() below
 * transfer data
 */
 /* USER CODE BEGIN enableScratchBuffer */
-/* #define ENABLE_SCRATCH_BUFFER */
+#define ENABLE_SCRATCH_BUFFER /* log buffer'larindan gelen hizasiz direct sector write'lari */
 /* USER CODE END enableScratchBuffer */
 
 /* Private variables ---------------------------------------------------------*/
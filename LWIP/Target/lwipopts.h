@@ -70,7 +70,7 @@
 /*----- Value in opt.h for LWIP_NETIF_LINK_CALLBACK: 0 -----*/
 #define LWIP_NETIF_LINK_CALLBACK 1
 /*----- Value in opt.h for TCPIP_THREAD_STACKSIZE: 0 -----*/
-#define TCPIP_THREAD_STACKSIZE 1024
+#define TCPIP_THREAD_STACKSIZE 2048
 /*----- Value in opt.h for TCPIP_THREAD_PRIO: 1 -----*/
 #define TCPIP_THREAD_PRIO 24
 /*----- Value in opt.h for TCPIP_MBOX_SIZE: 0 -----*/
@@ -118,6 +118,24 @@
 #define LWIP_NETCONN 1
 #define LWIP_SOCKET 0
 
+/* Modbus multi-client: APP_MODBUS_MAX_CONN sessions + listener (+ TIME_WAIT slack) */
+#define MEMP_NUM_NETCONN 8
+#define MEMP_NUM_TCP_PCB 8
+
+/* Sadece heap/pool kullanim sayaclari (FC04 sistem metrikleri); protokol sayaclari kapali */
+#undef LWIP_STATS
+#define LWIP_STATS 1
+#define MEM_STATS 1
+#define MEMP_STATS 1
+#define LINK_STATS 0
+#define ETHARP_STATS 0
+#define IP_STATS 0
+#define IPFRAG_STATS 0
+#define ICMP_STATS 0
+#define UDP_STATS 0
+#define TCP_STATS 0
+#define SYS_STATS 0
+
 
 /* USER CODE END 1 */
 
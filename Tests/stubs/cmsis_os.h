@@ -0,0 +1,51 @@
+#ifndef TEST_STUB_CMSIS_OS_H
+#define TEST_STUB_CMSIS_OS_H
+
+/* Host stub: CMSIS-RTOS2'nin testlerde kullanilan alt kumesi (pthread ile) */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+typedef void *osThreadId_t;
+typedef void *osMutexId_t;
+typedef struct { const char *name; uint32_t attr_bits; } osMutexAttr_t;
+typedef enum { osOK = 0, osError = -1, osErrorTimeout = -2 } osStatus_t;
+
+#define osWaitForever   0xFFFFFFFFu
+#define osFlagsWaitAny  0x00000000u
+#define osFlagsErrorTimeout 0xFFFFFFFEu
+
+/* Test tarafindan ilerletilir (stub_tick_ms) ya da gercek zamana bagli kalir */
+extern volatile uint32_t stub_tick_ms;
+
+static inline uint32_t osKernelGetTickCount(void) { return stub_tick_ms; }
+
+static inline osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+  (void)attr;
+  static pthread_mutex_t pool[64];
+  static int used = 0;
+  pthread_mutexattr_t a;
+  pthread_mutexattr_init(&a);
+  pthread_mutexattr_settype(&a, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&pool[used], &a);
+  return &pool[used++];
+}
+static inline osStatus_t osMutexAcquire(osMutexId_t m, uint32_t t)
+{
+  if (t == 0) return pthread_mutex_trylock((pthread_mutex_t *)m) ? osErrorTimeout : osOK;
+  pthread_mutex_lock((pthread_mutex_t *)m); /* diger timeout'lar: sonsuz */
+  return osOK;
+}
+static inline osStatus_t osMutexRelease(osMutexId_t m) { pthread_mutex_unlock((pthread_mutex_t *)m); return osOK; }
+
+/* Thread flags: thread basina flag kelimesi + condvar (stubs.c). Timeout gercek ms */
+osThreadId_t osThreadGetId(void);
+uint32_t osThreadFlagsSet(osThreadId_t t, uint32_t f);
+uint32_t osThreadFlagsWait(uint32_t f, uint32_t o, uint32_t t);
+
+/* ffconf.h _SYNC_t (FatFs kilidi Tests/stubs/sd_sim.c'de) */
+typedef void *osSemaphoreId_t;
+
+#endif
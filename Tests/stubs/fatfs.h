@@ -0,0 +1,8 @@
+#ifndef TEST_STUB_FATFS_H
+#define TEST_STUB_FATFS_H
+
+/* Host stub: CubeMX fatfs.h yerine. Gercek FatFs (Middlewares) derlenir, disk sd_sim.c */
+
+#include "ff.h"
+
+#endif
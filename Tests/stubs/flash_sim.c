@@ -0,0 +1,93 @@
+/* Host: retain flash simulasyonu, bkz. flash_sim.h */
+#include "flash_sim.h"
+#include "app_retain_flash.h"
+#include "app_config.h"
+
+#include <string.h>
+
+#define SIM_WORDS (APP_RETAIN_FLASH_SIZE / 4u)
+
+/* Zaman: silme/program suresi DWT'ye eklenir (erase_max_us olcumu) */
+#define SIM_ERASE_US   250000u
+#define SIM_PROGRAM_US 16u
+
+flash_sim_t g_flash_sim;
+static uint32_t s_mem[2][SIM_WORDS];
+
+static int sim_sector(uint32_t addr, uint32_t *idx)
+{
+  if (addr >= APP_RETAIN_FLASH_ADDR_A && addr < APP_RETAIN_FLASH_ADDR_A + APP_RETAIN_FLASH_SIZE) {
+    *idx = (addr - APP_RETAIN_FLASH_ADDR_A) / 4u;
+    return 0;
+  }
+  if (addr >= APP_RETAIN_FLASH_ADDR_B && addr < APP_RETAIN_FLASH_ADDR_B + APP_RETAIN_FLASH_SIZE) {
+    *idx = (addr - APP_RETAIN_FLASH_ADDR_B) / 4u;
+    return 1;
+  }
+  return -1;
+}
+
+static void sim_time(uint32_t us)
+{
+  DWT->CYCCNT += us * (SystemCoreClock / 1000000u);
+}
+
+/* 1: bu islem basarisiz */
+static int sim_fail(void)
+{
+  if (g_flash_sim.fail_in <= 0) return 0;
+  return (--g_flash_sim.fail_in == 0);
+}
+
+void flash_sim_reset(void)
+{
+  memset(&g_flash_sim, 0, sizeof(g_flash_sim));
+  memset(s_mem, 0xFF, sizeof(s_mem));
+  g_flash_sim.locked = 1;
+}
+
+void APP_RetainFlUnlock(void) { g_flash_sim.locked = 0; }
+void APP_RetainFlLock(void)   { g_flash_sim.locked = 1; }
+
+uint32_t APP_RetainFlRead(uint32_t addr)
+{
+  uint32_t i;
+  const int s = sim_sector(addr, &i);
+  return (s < 0) ? 0xFFFFFFFFu : s_mem[s][i];
+}
+
+uint8_t APP_RetainFlProgram(uint32_t addr, uint32_t w)
+{
+  uint32_t i;
+  const int s = sim_sector(addr, &i);
+  if (s < 0 || g_flash_sim.locked || (addr & 3u)) return 0;
+
+  sim_time(SIM_PROGRAM_US);
+  if (sim_fail()) {
+    if (g_flash_sim.power_cut) s_mem[s][i] &= (w | 0xFFFF0000u); /* alt yarisi yazildi */
+    return 0;
+  }
+  if ((s_mem[s][i] & w) != w) g_flash_sim.bad_programs++;
+  s_mem[s][i] &= w;
+  g_flash_sim.programs++;
+  return 1;
+}
+
+uint8_t APP_RetainFlErase(uint32_t sector)
+{
+  int s;
+  if (sector == APP_RETAIN_FLASH_SECTOR_A) s = 0;
+  else if (sector == APP_RETAIN_FLASH_SECTOR_B) s = 1;
+  else return 0;
+  if (g_flash_sim.locked) return 0;
+
+  sim_time(SIM_ERASE_US);
+  if (sim_fail()) {
+    if (g_flash_sim.power_cut) memset(s_mem[s], 0xFF, sizeof(s_mem[s]) / 2u);
+    return 0;
+  }
+  memset(s_mem[s], 0xFF, sizeof(s_mem[s]));
+  g_flash_sim.erases++;
+  g_flash_sim.sector_erases[s]++;
+  return 1;
+}
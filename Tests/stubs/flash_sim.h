@@ -0,0 +1,25 @@
+#ifndef TEST_FLASH_SIM_H
+#define TEST_FLASH_SIM_H
+
+/* Host: retain flash simulasyonu (app_retain_flash.h'in yerine). NOR davranisi:
+ * program sadece 1 -> 0 yapar (AND), erase sektoru 0xFF'ler. Hata enjeksiyonu:
+ * fail_in = n -> n. islem (program/erase) basarisiz olur; power_cut=1 ise o islem
+ * yarim kalir (program: word'un yarisi, erase: sektorun yarisi). */
+
+#include <stdint.h>
+
+typedef struct {
+  uint32_t programs;   /* basarili word program */
+  uint32_t erases;     /* basarili sektor silme */
+  uint32_t sector_erases[2];
+  uint32_t bad_programs; /* silinmemis bit'e 1 yazma denemesi (log format hatasi) */
+  int32_t  fail_in;    /* 0: kapali */
+  uint8_t  power_cut;
+  uint8_t  locked;
+} flash_sim_t;
+
+extern flash_sim_t g_flash_sim;
+
+void flash_sim_reset(void); /* sektorler silinmis, sayaclar 0 */
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef TEST_STUB_MAIN_H
+#define TEST_STUB_MAIN_H
+
+/* Host stub: ffconf.h main.h'i include ediyor */
+
+#include "stm32f4xx_hal.h"
+
+#endif
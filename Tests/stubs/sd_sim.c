@@ -0,0 +1,79 @@
+/* Host: RAM disk + SD gecikme modeli (FatFs diskio), FatFs kilidi ve zamani */
+#include "sd_sim.h"
+
+#include "ff.h"
+#include "diskio.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+sd_sim_t g_sd_sim;
+
+static uint8_t *s_disk = NULL;
+static uint32_t s_sectors = 0;
+static pthread_mutex_t s_ff_mu = PTHREAD_MUTEX_INITIALIZER;
+
+void sd_sim_init(uint32_t sectors)
+{
+  free(s_disk);
+  s_disk = calloc(sectors, 512u);
+  s_sectors = sectors;
+  memset(&g_sd_sim, 0, sizeof(g_sd_sim));
+}
+
+static void sleep_us(uint32_t us)
+{
+  struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L };
+  while (nanosleep(&ts, &ts) != 0) { }
+}
+
+DSTATUS disk_initialize(BYTE pdrv) { return (pdrv == 0 && s_disk) ? 0 : STA_NOINIT; }
+DSTATUS disk_status(BYTE pdrv)     { return (pdrv == 0 && s_disk) ? 0 : STA_NOINIT; }
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  if (pdrv != 0 || sector + count > s_sectors) return RES_PARERR;
+  memcpy(buff, s_disk + (size_t)sector * 512u, (size_t)count * 512u);
+  return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+  if (pdrv != 0 || sector + count > s_sectors) return RES_PARERR;
+  memcpy(s_disk + (size_t)sector * 512u, buff, (size_t)count * 512u);
+
+  uint32_t us = g_sd_sim.cmd_us + g_sd_sim.sect_us * count;
+  g_sd_sim.writes++;
+  g_sd_sim.write_sects += count;
+  if (g_sd_sim.stall_every && (g_sd_sim.writes % g_sd_sim.stall_every) == 0u) {
+    us += g_sd_sim.stall_us;
+    g_sd_sim.stalls++;
+  }
+  if (us) sleep_us(us);
+  return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+  if (pdrv != 0) return RES_PARERR;
+  switch (cmd) {
+    case CTRL_SYNC:        return RES_OK;
+    case GET_SECTOR_COUNT: *(DWORD *)buff = s_sectors; return RES_OK;
+    case GET_SECTOR_SIZE:  *(WORD *)buff = 512u; return RES_OK;
+    case GET_BLOCK_SIZE:   *(DWORD *)buff = 1u; return RES_OK;
+    default:               return RES_PARERR;
+  }
+}
+
+DWORD get_fattime(void)
+{
+  return ((DWORD)(2026 - 1980) << 25) | ((DWORD)10 << 21) | ((DWORD)17 << 16);
+}
+
+/* _FS_REENTRANT: tek volume, tek kilit */
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj) { (void)vol; *sobj = &s_ff_mu; return 1; }
+int ff_req_grant(_SYNC_t sobj) { pthread_mutex_lock((pthread_mutex_t *)sobj); return 1; }
+void ff_rel_grant(_SYNC_t sobj) { pthread_mutex_unlock((pthread_mutex_t *)sobj); }
+int ff_del_syncobj(_SYNC_t sobj) { (void)sobj; return 1; }
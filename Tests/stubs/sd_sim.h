@@ -0,0 +1,25 @@
+#ifndef TEST_SD_SIM_H
+#define TEST_SD_SIM_H
+
+/* Host: FatFs diskio'su RAM'de, SD karti gecikme modeliyle (gercek sleep). Yazma
+ * komutu basina cmd_us + sektor basina sect_us; her stall_every. yazma komutunda
+ * kart ici mesgul (GC / erase) stall_us eklenir. Okuma gecikmesizdir. */
+
+#include <stdint.h>
+
+typedef struct {
+  uint32_t cmd_us;
+  uint32_t sect_us;
+  uint32_t stall_every; /* 0: kapali */
+  uint32_t stall_us;
+  uint32_t writes;      /* yazma komutu */
+  uint32_t write_sects;
+  uint32_t stalls;
+} sd_sim_t;
+
+extern sd_sim_t g_sd_sim;
+
+/* sectors x 512 byte, sifirlanmis (calloc: dokunulmayan sayfa yer kaplamaz) */
+void sd_sim_init(uint32_t sectors);
+
+#endif
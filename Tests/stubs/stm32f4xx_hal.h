@@ -0,0 +1,43 @@
+#ifndef TEST_STUB_STM32F4XX_HAL_H
+#define TEST_STUB_STM32F4XX_HAL_H
+
+/* Host stub: app_config.h / app_*.c'nin ihtiyac duydugu CMSIS intrinsic'leri.
+ * Tek cekirdek IRQ maskesi host'ta thread'ler arasi dislama saglamaz; testler
+ * bunu writer'lari mutex ile serilestirerek (firmware'deki gibi) karsilar. */
+
+#include <stdint.h>
+
+extern __thread volatile uint32_t stub_primask; /* thread = "cekirdek" */
+extern volatile uint32_t stub_irq_disable_count;
+
+static inline uint32_t __get_PRIMASK(void) { return stub_primask; }
+static inline void __set_PRIMASK(uint32_t v) { stub_primask = v & 1u; }
+static inline void __disable_irq(void) { stub_primask = 1u; stub_irq_disable_count++; }
+static inline void __enable_irq(void) { stub_primask = 0u; }
+#define __DMB() __sync_synchronize()
+#define __DSB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+static inline uint32_t __REV16(uint32_t v) { return ((v & 0x00FF00FFu) << 8) | ((v & 0xFF00FF00u) >> 8); }
+
+#define FLASH_SECTOR_1 1u
+#define FLASH_SECTOR_2 2u
+
+/* app_retain: backup SRAM RAM'de, saat/DWT sahte (test ilerletir) */
+typedef enum { HAL_OK = 0, HAL_ERROR = 1 } HAL_StatusTypeDef;
+extern uint32_t stub_bkpsram[1024];
+#define BKPSRAM_BASE ((uintptr_t)stub_bkpsram)
+#define __HAL_RCC_PWR_CLK_ENABLE()    do { } while (0)
+#define __HAL_RCC_BKPSRAM_CLK_ENABLE() do { } while (0)
+static inline void HAL_PWR_EnableBkUpAccess(void) { }
+static inline HAL_StatusTypeDef HAL_PWREx_EnableBkUpReg(void) { return HAL_OK; }
+
+/* stub_tick_ms: cmsis_os.h */
+extern volatile uint32_t stub_tick_ms;
+static inline uint32_t HAL_GetTick(void) { return stub_tick_ms; }
+
+typedef struct { volatile uint32_t CYCCNT; } stub_dwt_t;
+extern stub_dwt_t stub_dwt;
+#define DWT (&stub_dwt)
+extern uint32_t SystemCoreClock;
+
+#endif
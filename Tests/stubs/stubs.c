@@ -0,0 +1,76 @@
+/* Host stub globals (cmsis_os.h / stm32f4xx_hal.h) */
+#include "stm32f4xx_hal.h"
+#include "cmsis_os.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+volatile uint32_t stub_tick_ms = 0;
+__thread volatile uint32_t stub_primask = 0;
+volatile uint32_t stub_irq_disable_count = 0;
+
+uint32_t stub_bkpsram[1024];
+stub_dwt_t stub_dwt;
+uint32_t SystemCoreClock = 168000000u;
+
+/* Thread flags: ilk osThreadGetId'de thread'e slot verilir, slot'lar serbest birakilmaz
+ * (thread bittikten sonra gelen osThreadFlagsSet gecerli bellege yazar) */
+typedef struct {
+  pthread_mutex_t mu;
+  pthread_cond_t  cv;
+  uint32_t        flags;
+} stub_thread_t;
+
+static stub_thread_t s_threads[32];
+static uint32_t s_thread_count = 0;
+static pthread_mutex_t s_thread_mu = PTHREAD_MUTEX_INITIALIZER;
+static __thread stub_thread_t *s_self = NULL;
+
+osThreadId_t osThreadGetId(void)
+{
+  if (s_self == NULL) {
+    pthread_mutex_lock(&s_thread_mu);
+    s_self = &s_threads[s_thread_count++];
+    pthread_mutex_init(&s_self->mu, NULL);
+    pthread_cond_init(&s_self->cv, NULL);
+    pthread_mutex_unlock(&s_thread_mu);
+  }
+  return s_self;
+}
+
+uint32_t osThreadFlagsSet(osThreadId_t t, uint32_t f)
+{
+  stub_thread_t *th = (stub_thread_t *)t;
+  pthread_mutex_lock(&th->mu);
+  th->flags |= f;
+  const uint32_t r = th->flags;
+  pthread_cond_signal(&th->cv);
+  pthread_mutex_unlock(&th->mu);
+  return r;
+}
+
+uint32_t osThreadFlagsWait(uint32_t f, uint32_t o, uint32_t t)
+{
+  (void)o; /* sadece osFlagsWaitAny */
+  stub_thread_t *th = (stub_thread_t *)osThreadGetId();
+  struct timespec dl;
+  clock_gettime(CLOCK_REALTIME, &dl);
+  if (t != osWaitForever) {
+    dl.tv_sec += (time_t)(t / 1000u);
+    dl.tv_nsec += (long)(t % 1000u) * 1000000L;
+    if (dl.tv_nsec >= 1000000000L) { dl.tv_sec++; dl.tv_nsec -= 1000000000L; }
+  }
+
+  pthread_mutex_lock(&th->mu);
+  while ((th->flags & f) == 0u) {
+    if (t == 0u) break;
+    const int rc = (t == osWaitForever) ? pthread_cond_wait(&th->cv, &th->mu)
+                                        : pthread_cond_timedwait(&th->cv, &th->mu, &dl);
+    if (rc == ETIMEDOUT) break;
+  }
+  const uint32_t got = th->flags & f;
+  th->flags &= ~got;
+  pthread_mutex_unlock(&th->mu);
+  return got ? got : osFlagsErrorTimeout;
+}
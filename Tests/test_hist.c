@@ -0,0 +1,70 @@
+/*
+ * Host test: yazma gecmisi ring'i (Core/Src/app_hist.c). Warm reset'te (APP_HistInit
+ * tekrar) kayitlar ve sira numarasi korunmali, bozuk/soguk header'da temizlenmeli.
+ * app_hist.c dogrudan include edilir (s_hdr static).
+ */
+#include "../Core/Src/app_hist.c"
+
+#include "test_util.h"
+
+static uint32_t hdr32(uint16_t hi)
+{
+  uint16_t w[2];
+  CHECK_EQ(APP_HistReadFile(APP_HIST_FILE_HDR, hi, w, 2), 2);
+  return ((uint32_t)w[0] << 16) | w[1];
+}
+
+static uint16_t entry_value(uint32_t k)
+{
+  uint16_t w[APP_HIST_ENTRY_WORDS];
+  const uint16_t rec = (uint16_t)((k % APP_HIST_COUNT) * APP_HIST_ENTRY_WORDS);
+  CHECK_EQ(APP_HistReadFile(APP_HIST_FILE_DATA, rec, w, APP_HIST_ENTRY_WORDS), APP_HIST_ENTRY_WORDS);
+  return w[3];
+}
+
+static void test_cold_boot_clears(void)
+{
+  memset(&s_hdr, 0xA5, sizeof(s_hdr)); /* guc aciliminda rastgele CCMRAM */
+  memset(s_ring, 0xA5, sizeof(s_ring));
+  APP_HistInit();
+  CHECK_EQ(hdr32(APP_HIST_HDR_TOTAL_HI), 0u);
+  CHECK_EQ(hdr32(APP_HIST_HDR_BOOT_HI), 0u);
+  CHECK_EQ(entry_value(0), 0u);
+}
+
+static void test_warm_reset_keeps(void)
+{
+  APP_HistInit();
+  const uint32_t t0 = hdr32(APP_HIST_HDR_TOTAL_HI);
+  const uint32_t n = APP_HIST_COUNT + 10u; /* ring bir tur doner */
+  for (uint32_t i = 0; i < n; ++i) APP_HistAppend(10, 3, 0x10, 0, 6, (uint16_t)(t0 + i));
+
+  APP_HistInit(); /* warm reset */
+  CHECK_EQ(hdr32(APP_HIST_HDR_TOTAL_HI), t0 + n);
+  CHECK_EQ(hdr32(APP_HIST_HDR_BOOT_HI), t0 + n);
+  uint16_t head;
+  CHECK_EQ(APP_HistReadFile(APP_HIST_FILE_HDR, APP_HIST_HDR_HEAD, &head, 1), 1);
+  CHECK_EQ(head, (t0 + n) % APP_HIST_COUNT);
+  CHECK_EQ(entry_value(t0 + n - 1u), (uint16_t)(t0 + n - 1u));
+  CHECK_EQ(entry_value(t0 + n - APP_HIST_COUNT), (uint16_t)(t0 + n - APP_HIST_COUNT));
+
+  APP_HistAppend(10, 3, 0x06, 1, 7, 0xBEEF);
+  CHECK_EQ(entry_value(t0 + n), 0xBEEFu);
+  CHECK_EQ(hdr32(APP_HIST_HDR_TOTAL_HI), t0 + n + 1u);
+}
+
+static void test_layout_change_clears(void)
+{
+  APP_HistAppend(10, 3, 0x06, 1, 7, 1);
+  s_hdr.layout ^= 1u; /* farkli firmware (kapasite/format) */
+  APP_HistInit();
+  CHECK_EQ(hdr32(APP_HIST_HDR_TOTAL_HI), 0u);
+}
+
+int main(void)
+{
+  RUN(test_cold_boot_clears);
+  RUN(test_warm_reset_keeps);
+  RUN(test_layout_change_clears);
+  return test_summary();
+}
@@ -0,0 +1,424 @@
+/*
+ * Host test: log task + writer (Core/Src/app_log.c) gercek FatFs (R0.12c) uzerinde,
+ * RAM disk + SD gecikme modeliyle (stubs/sd_sim.c). TIM7 4 kHz thread'den
+ * (APP_LogSamplerTickISR), log/writer task'lari pthread. Gercek zamanli calisir:
+ * smp_late / ring_drops / write_max_us olcumu host zamanlamasi icindir, hedefte
+ * metrics'ten (IR) okunur. Sektor benchmark'i (bench_sector_writes) gecikmesiz ve
+ * simule zamanla 1000 ROW kaydinin SD yazma sayisini eski yolla karsilastirir.
+ * app_log.c dogrudan include edilir (s_ch_count / g_stats static).
+ */
+#include "../Core/Src/app_log.c"
+
+#include "sd_sim.h"
+#include "test_util.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define DISK_SECTORS (1024u * 1024u) /* 512 MB: FAT32 (4 KB cluster) + 64 MB SMP on-tahsisi */
+#define RUN_S        8u
+
+/* SD modeli: 4-bit SDIO ~11 MB/s (45 us/sektor), komut + program busy ~0.8 ms.
+ * Dosyalar acildiktan sonra her 25. yazma komutunda kart ici GC 250 ms
+ * (SDHC yazma busy timeout'u; gercek kartlarda daha seyrek) */
+#define SD_CMD_US      800u
+#define SD_SECT_US     45u
+#define SD_STALL_EVERY 25u
+#define SD_STALL_US    250000u
+
+void APP_SupervisorKick(app_kick_source_t src) { (void)src; }
+
+/* 4 kanal gecerli; reddedilen: rate 0, bank disi tek register, 160'tan uzun satir,
+ * taninmayan karakter (kanal kismen uygulanir), kanal yeri kalmadi -> 5 */
+static const char *k_cfg_lines[] = {
+  "# rate_hz,addr[:deadband],...\n",
+  "100,6,7,8,9,10,11,12,13\n",
+  "0,6\n",
+  "100,14:3,15:3\n",
+  "100,99\n",
+  NULL, /* uzun satir (asagida) */
+  "50,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30\n",
+  "10,0,1,2x\n",
+  "20,6\n",
+};
+
+#define CH_A_HZ 100u
+#define CH_C_HZ 50u
+#define CH_D_HZ 10u
+
+static volatile int s_stop = 0;
+
+static void ts_add_ns(struct timespec *t, long ns)
+{
+  t->tv_nsec += ns;
+  while (t->tv_nsec >= 1000000000L) { t->tv_sec++; t->tv_nsec -= 1000000000L; }
+}
+
+/* TIM7: 4 kHz; HAL tick (ms) ve DWT (168 MHz) gercek zamandan */
+static void *isr_thread(void *arg)
+{
+  (void)arg;
+  struct timespec t0, next;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  next = t0;
+  while (!s_stop) {
+    ts_add_ns(&next, 1000000000L / APP_P10_SCAN_IRQ_HZ);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t ns = (uint64_t)(now.tv_sec - t0.tv_sec) * 1000000000u + (uint64_t)(now.tv_nsec - t0.tv_nsec);
+    stub_tick_ms = (uint32_t)(ns / 1000000u);
+    stub_dwt.CYCCNT = (uint32_t)(ns * 168u / 1000u);
+    APP_LogSamplerTickISR();
+  }
+  return NULL;
+}
+
+static void *log_thread(void *arg)    { APP_LogTask(arg); return NULL; }
+static void *writer_thread(void *arg) { APP_LogWriterTask(arg); return NULL; }
+
+/* Modbus yazicisi: 10 ms'de bir payload, saniyede bir SECONDS (ROW satiri).
+ * HR14 10 ms'de 1 artar: deadband 3 -> ~25 Hz tetik */
+static void *producer_thread(void *arg)
+{
+  (void)arg;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  uint32_t k = 0;
+  while (!s_stop) {
+    ts_add_ns(&next, 10000000L);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    ++k;
+    for (uint16_t a = 6; a < APP_MODBUS_HR_COUNT; ++a) {
+      if (a != 15u) (void)APP_RegsWriteHR(a, (uint16_t)((a == 14u) ? k : k * a));
+    }
+    if ((k % 100u) == 0u) (void)APP_RegsWriteHR(APP_HR_SECONDS, (uint16_t)((k / 100u) % 60u));
+  }
+  return NULL;
+}
+
+static void make_volume(void)
+{
+  static uint8_t work[4096];
+  static FATFS fs;
+  sd_sim_init(DISK_SECTORS);
+  CHECK_EQ(f_mkfs("", FM_FAT32, 4096, work, sizeof(work)), FR_OK);
+  CHECK_EQ(f_mount(&fs, "", 1), FR_OK);
+  CHECK_EQ(f_mkdir(APP_LOG_DIR), FR_OK);
+
+  FIL f;
+  UINT bw;
+  CHECK_EQ(f_open(&f, APP_LOG_SMP_CFG_FILE, FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+  for (size_t i = 0; i < sizeof(k_cfg_lines) / sizeof(k_cfg_lines[0]); ++i) {
+    if (k_cfg_lines[i] != NULL) {
+      (void)f_write(&f, k_cfg_lines[i], (UINT)strlen(k_cfg_lines[i]), &bw);
+      continue;
+    }
+    // 200+ karakter: devami ("7,8,...") ayri kanal gibi parse edilmemeli
+    char line[256] = "100";
+    while (strlen(line) < 200u) strcat(line, ",6,7,8,9,10,11,12,13,14,15,16,17");
+    strcat(line, "\n");
+    (void)f_write(&f, line, (UINT)strlen(line), &bw);
+  }
+  (void)f_close(&f);
+  (void)f_mount(NULL, "", 0);
+}
+
+static uint32_t rd32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+/* SMP dosyasi: header + record'lar; kanal basina record sayisi, CRC hatasi */
+static void parse_smp(uint32_t cnt[APP_LOG_SMP_CHANNELS], uint32_t *bad)
+{
+  static uint8_t buf[4u * 1024u * 1024u];
+  FIL f;
+  UINT br = 0;
+  char path[32];
+  log_path(path, sizeof(path), 2026, 10, 17, "SMP");
+  CHECK_EQ(f_open(&f, path, FA_READ), FR_OK);
+  CHECK_EQ(f_read(&f, buf, sizeof(buf), &br), FR_OK);
+  (void)f_close(&f);
+
+  uint8_t ch_n[APP_LOG_SMP_CHANNELS] = { 0 };
+  uint32_t off = 0;
+  while (off + 8u <= br) {
+    if (memcmp(&buf[off], LOG_SMP_MAGIC, 4) == 0) {
+      const uint16_t len = rd16(&buf[off + 4]);
+      if (crc16(&buf[off], len - 2u) != rd16(&buf[off + len - 2u])) { (*bad)++; return; }
+      const uint8_t *p = &buf[off + 8];
+      for (uint8_t k = 0; k < buf[off + 6] && k < APP_LOG_SMP_CHANNELS; ++k) {
+        ch_n[k] = p[0];
+        p += 4u + 2u * p[0];
+      }
+      off += len;
+      continue;
+    }
+    const uint8_t ch = buf[off], n = buf[off + 1];
+    const uint32_t len = 6u + 2u * n + 2u;
+    if (ch >= APP_LOG_SMP_CHANNELS || n != ch_n[ch] || off + len > br ||
+        crc16(&buf[off], len - 2u) != rd16(&buf[off + len - 2u])) {
+      (*bad)++;
+      return;
+    }
+    (void)rd32(&buf[off + 2]);
+    cnt[ch]++;
+    off += len;
+  }
+}
+
+static void test_sampler_run(void)
+{
+  make_volume();
+
+  APP_RegsInit();
+  (void)APP_RegsWriteHR(APP_HR_YEAR, 2026);
+  (void)APP_RegsWriteHR(APP_HR_MONTH, 10);
+  (void)APP_RegsWriteHR(APP_HR_DAY, 17);
+  (void)APP_RegsWriteHR(APP_HR_LOG_ENABLE, 1);
+
+  APP_LogInit();
+  CHECK_EQ(g_fs_mounted, 1);
+  CHECK_EQ(s_ch_count, 4);
+  CHECK_EQ(g_stats.smp_rejects, 5u);
+  CHECK_EQ(s_ch[3].n, 3); /* "10,0,1,2x": kismen */
+
+  g_sd_sim.cmd_us = SD_CMD_US;
+  g_sd_sim.sect_us = SD_SECT_US;
+
+  pthread_t th[4];
+  pthread_create(&th[0], NULL, isr_thread, NULL);
+  pthread_create(&th[1], NULL, writer_thread, NULL);
+  pthread_create(&th[2], NULL, log_thread, NULL);
+  pthread_create(&th[3], NULL, producer_thread, NULL);
+
+  /* 1. faz: gun dosyalari acilir (f_expand: ROW 8 MB + SMP 64 MB FAT zinciri) */
+  struct timespec d = { 1, 0 };
+  nanosleep(&d, NULL);
+  const uint32_t open_us = g_stats.write_max_us;
+  const uint32_t open_writes = g_sd_sim.writes;
+  const uint32_t open_hwm = s_ring_hwm;
+  CHECK(s_st[LOG_STREAM_SMP].open && s_st[LOG_STREAM_SMP].seg.active);
+  printf("  acilis: %u yazma komutu, en uzun %u us, ring_hwm %u\n", open_writes, open_us, open_hwm);
+
+  /* 2. faz: kalici durum, periyodik kart stall'u */
+  g_stats.write_max_us = 0;
+  g_sd_sim.stall_every = SD_STALL_EVERY;
+  g_sd_sim.stall_us = SD_STALL_US;
+  d.tv_sec = RUN_S;
+  nanosleep(&d, NULL);
+  const uint32_t ticks = s_smp_tick;
+  (void)APP_RegsWriteHR(APP_HR_LOG_ENABLE, 0); /* CLOSE: staging + sync + close */
+  d.tv_sec = 1;
+  nanosleep(&d, NULL);
+  s_stop = 1;
+  pthread_join(th[0], NULL);
+  pthread_join(th[3], NULL);
+  d.tv_sec = 1;
+  nanosleep(&d, NULL); /* log/writer bekliyor; FatFs kilidi serbest */
+
+  app_log_stats_t st;
+  APP_LogGetStats(&st);
+  printf("  +%u s (toplam %u sampler tick), SD %u+%u us/sektor, her %u. yazmada %u ms stall (%u stall)\n",
+         RUN_S, ticks, SD_CMD_US, SD_SECT_US, SD_STALL_EVERY, SD_STALL_US / 1000u, g_sd_sim.stalls);
+  printf("  lines %u, flushes %u, syncs %u, SD yazma %u komut / %u sektor\n",
+         st.lines, st.flushes, st.syncs, g_sd_sim.writes, g_sd_sim.write_sects);
+  printf("  smp_late %u, ring_drops %u, ring_hwm %u / %u, write_max_us %u, smp_rejects %u\n",
+         st.smp_late, st.ring_drops, st.ring_hwm, APP_LOG_RING_SLOTS, st.write_max_us, st.smp_rejects);
+
+  uint32_t cnt[APP_LOG_SMP_CHANNELS] = { 0 };
+  uint32_t bad = 0;
+  parse_smp(cnt, &bad);
+  printf("  SMP record: A %u, B(deadband) %u, C %u, D %u, bozuk %u\n", cnt[0], cnt[1], cnt[2], cnt[3], bad);
+
+  /* 250 ms stall ~25 kayit/kanal biriktirir: 512 slot kayipsiz karsilamali */
+  CHECK_EQ(st.ring_drops, 0u);
+  CHECK_EQ(bad, 0u);
+  CHECK(g_sd_sim.stalls > 0u);
+  CHECK(st.write_max_us >= SD_STALL_US);
+  /* her tick bir ornek: kacirilan tick kadar eksik */
+  const uint32_t per_a = ticks / (APP_LOG_SMP_TICK_HZ / CH_A_HZ);
+  CHECK(cnt[0] + st.smp_late + 2u >= per_a);
+  CHECK(cnt[2] + st.smp_late + 2u >= ticks / (APP_LOG_SMP_TICK_HZ / CH_C_HZ));
+  CHECK(cnt[3] + 2u >= ticks / (APP_LOG_SMP_TICK_HZ / CH_D_HZ));
+  CHECK(cnt[1] > 0u && cnt[1] < cnt[0]);
+}
+
+/* Zincirin cluster sayisi (tek fragment), parcaliysa 0 */
+static DWORD chain_clusters(const char *path)
+{
+  FIL f;
+  DWORD tbl[4] = { 4u };
+  if (f_open(&f, path, FA_READ) != FR_OK) return 0;
+  f.cltbl = tbl;
+  const FRESULT fr = f_lseek(&f, CREATE_LINKMAP);
+  (void)f_close(&f);
+  return (fr == FR_OK) ? tbl[1] : 0u;
+}
+
+/* test_sampler_run'in ardindan: log kapatildi (close_file final degil), dosyalar
+ * on-tahsisli kaldi. Reboot sonrasi ertesi gunun ilk acilisi eskiyi kirpmali. */
+static void test_trim_stale_after_reboot(void)
+{
+  const DWORD cl = (DWORD)g_fs.csize * LOG_SS;
+  char smp[32], row[32];
+  log_path(smp, sizeof(smp), 2026, 10, 17, "SMP");
+  log_path(row, sizeof(row), 2026, 10, 17, s_st[LOG_STREAM_ROW].ext);
+
+  FILINFO fi;
+  CHECK_EQ(f_stat(smp, &fi), FR_OK);
+  const FSIZE_t smp_size = fi.fsize;
+  CHECK_EQ(chain_clusters(smp), APP_LOG_SMP_PREALLOC_BYTES / cl);
+
+  DWORD free0 = 0, free1 = 0;
+  FATFS *fs;
+  CHECK_EQ(f_getfree("", &free0, &fs), FR_OK);
+
+  // reboot: dosyalar kapali, gun 18
+  CHECK_EQ(s_st[LOG_STREAM_SMP].open, 0);
+  const uint32_t trims0 = g_stats.trims;
+  CHECK(open_daily_file(&s_st[LOG_STREAM_SMP], 2026, 10, 18));
+  CHECK(open_daily_file(&s_st[LOG_STREAM_ROW], 2026, 10, 18));
+  CHECK_EQ(g_stats.trims - trims0, 2u);
+
+  // iki akis acikken gecmis gun okunabilmeli (_FS_LOCK)
+  uint8_t hdr[8];
+  CHECK_EQ(APP_LogReadAt(2026, 10, 17, 0, hdr, sizeof(hdr)), (int32_t)sizeof(hdr));
+  CHECK_EQ(APP_LogReadAt(2026, 10, 18, 0, hdr, sizeof(hdr)), -1); /* bugun: writer'da acik */
+
+  // ayni gun tekrar acilis (dosya var): tarama yok
+  close_file(&s_st[LOG_STREAM_SMP], false);
+  CHECK(open_daily_file(&s_st[LOG_STREAM_SMP], 2026, 10, 18));
+  CHECK_EQ(g_stats.trims - trims0, 2u);
+
+  close_file(&s_st[LOG_STREAM_SMP], true);
+  close_file(&s_st[LOG_STREAM_ROW], true);
+  CHECK_EQ(f_stat(smp, &fi), FR_OK);
+  CHECK_EQ(fi.fsize, smp_size);
+  CHECK_EQ(chain_clusters(smp), (smp_size + cl - 1u) / cl);
+  CHECK(chain_clusters(row) <= 1u);
+  CHECK_EQ(f_getfree("", &free1, &fs), FR_OK);
+  printf("  birakilan: %u cluster (%u KB)\n", (unsigned)(free1 - free0), (unsigned)((free1 - free0) * (cl / 1024u)));
+  CHECK(free1 - free0 >= (APP_LOG_SMP_PREALLOC_BYTES + APP_LOG_PREALLOC_BYTES) / cl - 64u);
+}
+
+/* ---- sektor yazma benchmark'i: satir basina f_write + periyodik f_sync vs staging ---- */
+
+#define BENCH_RECS          1000u
+#define OLD_SYNC_PERIOD_MS  1000u /* eski APP_LOG_SYNC_PERIOD_MS */
+
+typedef struct {
+  uint32_t sects;
+  uint32_t cmds;
+} sd_count_t;
+
+static sd_count_t sd_count(void)
+{
+  const sd_count_t c = { g_sd_sim.write_sects, g_sd_sim.writes };
+  return c;
+}
+
+static sd_count_t sd_since(sd_count_t c0)
+{
+  const sd_count_t c = { g_sd_sim.write_sects - c0.sects, g_sd_sim.writes - c0.cmds };
+  return c;
+}
+
+/* k. kaydin snapshot'i: ROW gibi MMM/SS + degisen payload (satir boyu ~60 byte) */
+static UINT bench_line(char *line, size_t cap, uint32_t k, uint32_t tick_ms)
+{
+  uint16_t snap[APP_MODBUS_HR_COUNT] = { 0 };
+  snap[APP_HR_MINUTES] = (uint16_t)((k / 60u) % 1000u);
+  snap[APP_HR_SECONDS] = (uint16_t)(k % 60u);
+  for (uint16_t a = APP_LOG_PAYLOAD_START_HR; a < LOG_SNAP_COUNT; ++a) snap[a] = (uint16_t)(k * a);
+  return fmt_csv_record(line, cap, tick_ms, snap);
+}
+
+/* Eski yol (user-022 oncesi): satir basina f_write, OLD_SYNC_PERIOD_MS'de bir f_sync */
+static sd_count_t bench_old(uint32_t period_ms, uint8_t day)
+{
+  char path[32], line[256];
+  FIL f;
+  UINT bw;
+  log_path(path, sizeof(path), 2026, 11, day, "OLD");
+  CHECK_EQ(f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+  const UINT hl = bench_line(line, sizeof(line), 0, 0); /* header yerine: dosya bos baslamasin */
+  (void)f_write(&f, line, hl, &bw);
+  (void)f_sync(&f);
+
+  const sd_count_t c0 = sd_count();
+  uint32_t tick = 0, last_sync = 0;
+  for (uint32_t k = 1; k <= BENCH_RECS; ++k) {
+    tick += period_ms;
+    const UINT len = bench_line(line, sizeof(line), k, tick);
+    CHECK(f_write(&f, line, len, &bw) == FR_OK && bw == len);
+    if (tick - last_sync >= OLD_SYNC_PERIOD_MS) {
+      (void)f_sync(&f);
+      last_sync = tick;
+    }
+  }
+  (void)f_sync(&f);
+  const sd_count_t c = sd_since(c0);
+  (void)f_close(&f);
+  return c;
+}
+
+/* Yeni yol: writer'in staging + on-tahsis + durability window'u. Writer thread'i
+ * s_st'ye bakar; ayri stream ile ona dokunulmaz. open: gun acilisi (f_expand) */
+static sd_count_t bench_new(uint32_t period_ms, uint8_t day, sd_count_t *open)
+{
+  static log_stream_t bst __attribute__((aligned(4)));
+  char line[256];
+  memset(&bst, 0, sizeof(bst));
+  bst.ext = "NEW";
+  bst.prealloc = APP_LOG_PREALLOC_BYTES;
+
+  const sd_count_t o0 = sd_count();
+  CHECK(open_daily_file(&bst, 2026, 11, day));
+  CHECK(bst.seg.active);
+  *open = sd_since(o0);
+
+  const sd_count_t c0 = sd_count();
+  uint32_t tick = 0;
+  for (uint32_t k = 1; k <= BENCH_RECS; ++k) {
+    tick += period_ms;
+    stub_tick_ms = tick;
+    const UINT len = bench_line(line, sizeof(line), k, tick);
+    stage_append(&bst, (const uint8_t *)line, len);
+    if (bst.unsynced && (tick - bst.unsynced_t0) >= APP_LOG_FLUSH_MAX_AGE_MS) writer_sync(&bst);
+  }
+  writer_sync(&bst);
+  const sd_count_t c = sd_since(c0);
+  close_file(&bst, true);
+  return c;
+}
+
+/* Gecikmesiz SD modeli: yalniz komut / sektor sayilir. 1 Hz = ROW (MMM/SS), 100 Hz =
+ * sampler kanali hizinda satir */
+static void bench_sector_writes(void)
+{
+  static const uint32_t hz[] = { 1u, 100u };
+  g_sd_sim.cmd_us = 0;
+  g_sd_sim.sect_us = 0;
+  g_sd_sim.stall_every = 0;
+
+  for (size_t i = 0; i < sizeof(hz) / sizeof(hz[0]); ++i) {
+    const uint8_t day = (uint8_t)(1u + 2u * i);
+    sd_count_t open;
+    const sd_count_t o = bench_old(1000u / hz[i], day);
+    const sd_count_t n = bench_new(1000u / hz[i], (uint8_t)(day + 1u), &open);
+    printf("  %3u kayit/s, %u kayit: eski %4u sektor / %4u komut, yeni %4u sektor / %4u komut"
+           " (gun acilisi +%u sektor)\n",
+           hz[i], BENCH_RECS, o.sects, o.cmds, n.sects, n.cmds, open.sects);
+    CHECK(n.sects < o.sects);
+    CHECK(n.cmds < o.cmds);
+  }
+}
+
+int main(void)
+{
+  RUN(test_sampler_run);
+  RUN(test_trim_stale_after_reboot);
+  RUN(bench_sector_writes);
+  return test_summary();
+}
@@ -0,0 +1,218 @@
+/*
+ * Host test: MBAP stream reassembler (Core/Src/app_mbap.c).
+ * Parcalanmis, birlesik, cop onekli stream'ler + backpressure (fn 0 donerse
+ * ayni ADU'dan devam) + byte basina maliyet microbenchmark'i.
+ */
+#include "app_mbap.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_ADUS 4096u
+
+typedef struct {
+  uint32_t count;
+  uint32_t refuse_every; /* 0: hep kabul; n: her n. cagrida bir kez reddet */
+  uint32_t calls;
+  uint8_t  refused_last;
+  uint16_t len[MAX_ADUS];
+  uint16_t tid[MAX_ADUS];
+} sink_t;
+
+static int sink_fn(void *ctx, const uint8_t *adu, uint16_t len)
+{
+  sink_t *s = (sink_t *)ctx;
+  s->calls++;
+  if (s->refuse_every && !s->refused_last && (s->calls % s->refuse_every) == 0u) {
+    s->refused_last = 1;
+    return 0;
+  }
+  s->refused_last = 0;
+  if (s->count < MAX_ADUS) {
+    s->len[s->count] = len;
+    s->tid[s->count] = (uint16_t)((adu[0] << 8) | adu[1]);
+  }
+  s->count++;
+  return 1;
+}
+
+/* FC03 istegi (12 byte) ya da FC16 (13 + 2*qty) */
+static size_t put_adu(uint8_t *p, uint16_t tid, uint16_t qty_wr)
+{
+  const uint16_t pdu = qty_wr ? (uint16_t)(6u + 2u * qty_wr) : 5u;
+  p[0] = (uint8_t)(tid >> 8); p[1] = (uint8_t)tid;
+  p[2] = 0; p[3] = 0;
+  p[4] = (uint8_t)((pdu + 1u) >> 8); p[5] = (uint8_t)(pdu + 1u);
+  p[6] = 10;
+  p[7] = qty_wr ? 16 : 3;
+  p[8] = 0; p[9] = 6;
+  p[10] = (uint8_t)((qty_wr ? qty_wr : 16u) >> 8); p[11] = (uint8_t)(qty_wr ? qty_wr : 16u);
+  if (!qty_wr) return 12u;
+  p[12] = (uint8_t)(2u * qty_wr);
+  for (uint16_t i = 0; i < 2u * qty_wr; ++i) p[13 + i] = (uint8_t)i;
+  return 13u + 2u * qty_wr;
+}
+
+/* n ADU, karisik boy; tids 1..n */
+static size_t build_stream(uint8_t *buf, uint32_t n)
+{
+  size_t len = 0;
+  for (uint32_t i = 0; i < n; ++i) len += put_adu(&buf[len], (uint16_t)(i + 1u), (uint16_t)((i % 5u) * 30u));
+  return len;
+}
+
+/* stream'i chunk'lar halinde besle; reddedilen kisim ayni sirayla tekrar */
+static void feed_chunks(app_mbap_rx_t *rx, sink_t *s, const uint8_t *buf, size_t len, size_t chunk)
+{
+  size_t off = 0;
+  while (off < len) {
+    size_t n = (len - off < chunk) ? len - off : chunk;
+    size_t done = 0;
+    while (done < n) done += APP_MbapFeed(rx, buf + off + done, n - done, sink_fn, s);
+    off += n;
+  }
+}
+
+static void check_order(const sink_t *s, uint32_t n)
+{
+  CHECK_EQ(s->count, n);
+  for (uint32_t i = 0; i < n && i < MAX_ADUS; ++i) CHECK_EQ(s->tid[i], i + 1u);
+}
+
+static uint8_t g_buf[512u * 1024u];
+
+static void test_whole_and_split(void)
+{
+  const uint32_t n = 500;
+  const size_t len = build_stream(g_buf, n);
+  static const size_t chunks[] = { 1, 2, 3, 7, 11, 12, 13, 64, 259, 260, 536, 1460, 100000 };
+
+  for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k) {
+    app_mbap_rx_t rx;
+    static sink_t s;
+    APP_MbapReset(&rx);
+    memset(&s, 0, sizeof(s));
+    feed_chunks(&rx, &s, g_buf, len, chunks[k]);
+    check_order(&s, n);
+    CHECK_EQ(rx.have, 0u);
+    CHECK_EQ(rx.resync_bytes, 0u);
+    if (chunks[k] >= len) CHECK_EQ(rx.copied_bytes, 0u); /* tek segment: kopyasiz */
+  }
+}
+
+static void test_garbage_prefix(void)
+{
+  static const uint8_t junk[] = { 0xFF, 0x00, 0x13, 0x00, 0x01, 0x00, 0xFF, 0x7F, 0x00, 0x00, 0x00 };
+  const uint32_t n = 50;
+  memcpy(g_buf, junk, sizeof(junk));
+  const size_t len = sizeof(junk) + build_stream(&g_buf[sizeof(junk)], n);
+
+  static const size_t chunks[] = { 1, 5, 8, 100000 };
+  for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k) {
+    app_mbap_rx_t rx;
+    static sink_t s;
+    APP_MbapReset(&rx);
+    memset(&s, 0, sizeof(s));
+    feed_chunks(&rx, &s, g_buf, len, chunks[k]);
+    check_order(&s, n);
+    CHECK_EQ(rx.resync_bytes, sizeof(junk));
+  }
+}
+
+static void test_garbage_between(void)
+{
+  size_t len = put_adu(g_buf, 1, 0);
+  g_buf[len++] = 0xAA;              /* pid != 0 gibi gorunen cop */
+  g_buf[len++] = 0x00;
+  g_buf[len++] = 0x55;
+  len += put_adu(&g_buf[len], 2, 10);
+
+  for (size_t chunk = 1; chunk <= len; ++chunk) {
+    app_mbap_rx_t rx;
+    static sink_t s;
+    APP_MbapReset(&rx);
+    memset(&s, 0, sizeof(s));
+    feed_chunks(&rx, &s, g_buf, len, chunk);
+    check_order(&s, 2);
+    CHECK_EQ(rx.resync_bytes, 3u);
+  }
+}
+
+static void test_backpressure(void)
+{
+  const uint32_t n = 300;
+  const size_t len = build_stream(g_buf, n);
+  static const size_t chunks[] = { 1, 9, 13, 536, 100000 };
+  static const uint32_t every[] = { 1, 2, 3, 7 };
+
+  for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k) {
+    for (size_t e = 0; e < sizeof(every) / sizeof(every[0]); ++e) {
+      app_mbap_rx_t rx;
+      static sink_t s;
+      APP_MbapReset(&rx);
+      memset(&s, 0, sizeof(s));
+      s.refuse_every = every[e];
+      feed_chunks(&rx, &s, g_buf, len, chunks[k]);
+      check_order(&s, n);
+      CHECK_EQ(rx.adu_count, n);
+    }
+  }
+}
+
+static void test_frame_len(void)
+{
+  uint8_t h[12];
+  (void)put_adu(h, 1, 0);
+  CHECK_EQ(APP_MbapFrameLen(h), 12u);
+  h[2] = 1; /* PID != 0 */
+  CHECK_EQ(APP_MbapFrameLen(h), 0u);
+  h[2] = 0; h[5] = 1; /* LEN < 2 */
+  CHECK_EQ(APP_MbapFrameLen(h), 0u);
+  h[4] = 0x01; h[5] = 0x00; /* LEN 256 > 253 */
+  CHECK_EQ(APP_MbapFrameLen(h), 0u);
+}
+
+static int bench_sink(void *ctx, const uint8_t *adu, uint16_t len)
+{
+  (void)adu;
+  *(uint32_t *)ctx += len;
+  return 1;
+}
+
+static void bench(void)
+{
+  const size_t len = build_stream(g_buf, 3000);
+  static const size_t chunks[] = { 1460, 536, 64 };
+
+  for (size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k) {
+    app_mbap_rx_t rx;
+    APP_MbapReset(&rx);
+    uint32_t sink = 0;
+    const int rounds = 50;
+    const double t0 = test_now_s();
+    for (int r = 0; r < rounds; ++r) {
+      for (size_t off = 0; off < len; off += chunks[k]) {
+        const size_t n = (len - off < chunks[k]) ? len - off : chunks[k];
+        (void)APP_MbapFeed(&rx, g_buf + off, n, bench_sink, &sink);
+      }
+    }
+    const double dt = test_now_s() - t0;
+    printf("  bench chunk %4zu: %6.1f ns/ADU, %5.2f ns/byte, stash copy %.1f%%\n", chunks[k],
+           dt * 1e9 / (3000.0 * rounds), dt * 1e9 / ((double)len * rounds),
+           100.0 * (double)rx.copied_bytes / ((double)len * rounds));
+  }
+}
+
+int main(void)
+{
+  RUN(test_frame_len);
+  RUN(test_whole_and_split);
+  RUN(test_garbage_prefix);
+  RUN(test_garbage_between);
+  RUN(test_backpressure);
+  bench();
+  return test_summary();
+}
@@ -0,0 +1,429 @@
+/*
+ * Host test: register bank seqlock + transaction (Core/Src/app_regs.c).
+ * Writer thread'leri bloklari tek degerle doldururken reader'lar lock-free okur;
+ * hicbir snapshot yirtik (karisik generation) olmamali. Okuma maliyeti mutex'li
+ * okuma ile karsilastirilir (stress benchmark). Transaction: sahiplik (diger kaynak
+ * busy), yerel yazmalarin commit'te korunmasi, timeout / baglanti kapanisi ile iptal
+ * ve iki ayri yazmayla kurulan grubun reader'lara yirtik gorunmemesi. Bit store:
+ * ayni word'leri paylasan writer'lar (her biri kendi bitleri) reader'lara karsi
+ * read-modify-write (APP_RegsBitsWrite) ve atomik (APP_RegsBitsSet) yoldan yazar;
+ * op/s karsilastirilir, kayip guncelleme olmamali.
+ */
+#include "app_regs.h"
+#include "test_util.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define BLK_ADDR 6u
+#define BLK_QTY  16u
+
+static atomic_int g_stop;
+static atomic_ulong g_torn;
+static atomic_ulong g_writes;
+
+typedef struct {
+  unsigned long reads;
+  int           use_mutex; /* karsilastirma: her okumada bank mutex'i */
+} reader_t;
+
+static void *writer_fn(void *arg)
+{
+  const uint16_t base = (uint16_t)(uintptr_t)arg;
+  uint16_t v[BLK_QTY];
+  for (uint32_t i = 0; !atomic_load(&g_stop); ++i) {
+    for (uint16_t k = 0; k < BLK_QTY; ++k) v[k] = (uint16_t)(base + (i & 0x3FFFu));
+    (void)APP_RegsWriteHRBlock(BLK_ADDR, v, BLK_QTY);
+    atomic_fetch_add(&g_writes, 1);
+  }
+  return NULL;
+}
+
+static void *reader_fn(void *arg)
+{
+  reader_t *r = (reader_t *)arg;
+  uint16_t out[BLK_QTY];
+  while (!atomic_load(&g_stop)) {
+    if (r->use_mutex) {
+      app_regs_bank_t *b = APP_RegsMainBank();
+      osMutexAcquire(b->mutex, osWaitForever);
+      memcpy(out, (const uint16_t *)&b->hr[BLK_ADDR], sizeof(out));
+      osMutexRelease(b->mutex);
+    } else {
+      (void)APP_RegsReadHRBlock(BLK_ADDR, out, BLK_QTY);
+    }
+    for (uint16_t k = 1; k < BLK_QTY; ++k) {
+      if (out[k] != out[0]) {
+        atomic_fetch_add(&g_torn, 1);
+        break;
+      }
+    }
+    r->reads++;
+  }
+  return NULL;
+}
+
+static void stress(int writers, int readers, int use_mutex, double seconds)
+{
+  pthread_t wt[4], rt[8];
+  reader_t rs[8];
+  memset(rs, 0, sizeof(rs));
+  atomic_store(&g_stop, 0);
+  atomic_store(&g_torn, 0);
+  atomic_store(&g_writes, 0);
+
+  for (int i = 0; i < writers; ++i) pthread_create(&wt[i], NULL, writer_fn, (void *)(uintptr_t)(i * 0x4000));
+  for (int i = 0; i < readers; ++i) {
+    rs[i].use_mutex = use_mutex;
+    pthread_create(&rt[i], NULL, reader_fn, &rs[i]);
+  }
+
+  const double t0 = test_now_s();
+  while (test_now_s() - t0 < seconds) { }
+  atomic_store(&g_stop, 1);
+  for (int i = 0; i < writers; ++i) pthread_join(wt[i], NULL);
+  for (int i = 0; i < readers; ++i) pthread_join(rt[i], NULL);
+
+  unsigned long reads = 0;
+  for (int i = 0; i < readers; ++i) reads += rs[i].reads;
+  printf("  %d writer / %d reader (%s): %6.2f M snapshot/s, %6.2f M yazma/s, yirtik %lu\n", writers, readers,
+         use_mutex ? "mutex    " : "lock-free", (double)reads / seconds / 1e6,
+         (double)atomic_load(&g_writes) / seconds / 1e6,
+         (unsigned long)atomic_load(&g_torn));
+  CHECK_EQ(atomic_load(&g_torn), 0u);
+  CHECK(reads > 0);
+}
+
+/* ---- bit store ---- */
+
+#define BIT_COUNT   64u
+#define BIT_WRITERS 4
+
+enum { BIT_RMW_LOCKED, BIT_RMW_RAW, BIT_ATOMIC };
+
+static uint32_t        s_bit_store[APP_REGS_BITS_WORDS(BIT_COUNT)];
+static app_regs_bits_t s_bits;
+/* Firmware'de BitsWrite IRQ kapali calisir (tek cekirdek = writer'lar sirali);
+ * host'ta PRIMASK stub oldugundan ayni siralamayi bu mutex verir */
+static pthread_mutex_t s_bit_irq = PTHREAD_MUTEX_INITIALIZER;
+static atomic_ulong    g_bit_lost;
+
+typedef struct {
+  int           id;
+  int           mode;
+  unsigned long ops;
+  uint8_t       last[BIT_COUNT / BIT_WRITERS];
+} bit_writer_t;
+
+/* Writer i bitleri i, i+4, i+8, ...: hepsi ayni iki word'u paylasir. Bir biti
+ * yeniden yazmadan once son yazdigi degerde mi diye bakar; degilse baskasinin
+ * RMW'si uzerine yazmistir (kayip guncelleme). */
+static void *bit_writer_fn(void *arg)
+{
+  bit_writer_t *w = (bit_writer_t *)arg;
+  for (uint32_t n = 0; !atomic_load(&g_stop); ++n) {
+    const uint32_t k    = n % (BIT_COUNT / BIT_WRITERS);
+    const uint16_t addr = (uint16_t)(w->id + BIT_WRITERS * k);
+    if (APP_RegsBitsGet(&s_bits, addr) != w->last[k]) atomic_fetch_add(&g_bit_lost, 1);
+
+    const uint8_t v = (uint8_t)(((n / (BIT_COUNT / BIT_WRITERS)) + (uint32_t)w->id) & 1u);
+    if (w->mode == BIT_ATOMIC) {
+      (void)APP_RegsBitsSet(&s_bits, addr, v);
+    } else {
+      if (w->mode == BIT_RMW_LOCKED) pthread_mutex_lock(&s_bit_irq);
+      (void)APP_RegsBitsWrite(&s_bits, addr, &v, 1);
+      if (w->mode == BIT_RMW_LOCKED) pthread_mutex_unlock(&s_bit_irq);
+    }
+    w->last[k] = v;
+    w->ops++;
+  }
+  return NULL;
+}
+
+static void *bit_reader_fn(void *arg)
+{
+  unsigned long *reads = (unsigned long *)arg;
+  uint8_t packed[BIT_COUNT / 8u];
+  while (!atomic_load(&g_stop)) {
+    (void)APP_RegsBitsRead(&s_bits, 0, packed, BIT_COUNT);
+    (*reads)++;
+  }
+  return NULL;
+}
+
+static unsigned long bit_stress(int mode, int readers, double seconds)
+{
+  static const char *const names[] = { "RMW (IRQ kapali)", "RMW kilitsiz    ", "atomik          " };
+  pthread_t wt[BIT_WRITERS], rt[4];
+  bit_writer_t ws[BIT_WRITERS];
+  unsigned long rd[4] = { 0 };
+  memset(ws, 0, sizeof(ws));
+  APP_RegsBitsInit(&s_bits, s_bit_store, BIT_COUNT);
+  atomic_store(&g_stop, 0);
+  atomic_store(&g_bit_lost, 0);
+
+  for (int i = 0; i < BIT_WRITERS; ++i) {
+    ws[i].id   = i;
+    ws[i].mode = mode;
+    pthread_create(&wt[i], NULL, bit_writer_fn, &ws[i]);
+  }
+  for (int i = 0; i < readers; ++i) pthread_create(&rt[i], NULL, bit_reader_fn, &rd[i]);
+
+  const double t0 = test_now_s();
+  while (test_now_s() - t0 < seconds) { }
+  atomic_store(&g_stop, 1);
+  for (int i = 0; i < BIT_WRITERS; ++i) pthread_join(wt[i], NULL);
+  for (int i = 0; i < readers; ++i) pthread_join(rt[i], NULL);
+
+  /* son durum: her bit sahibinin son yazdigi deger */
+  unsigned long ops = 0, reads = 0, lost = atomic_load(&g_bit_lost);
+  for (int i = 0; i < BIT_WRITERS; ++i) {
+    ops += ws[i].ops;
+    for (uint32_t k = 0; k < BIT_COUNT / BIT_WRITERS; ++k) {
+      if (APP_RegsBitsGet(&s_bits, (uint16_t)(i + BIT_WRITERS * k)) != ws[i].last[k]) lost++;
+    }
+  }
+  for (int i = 0; i < readers; ++i) reads += rd[i];
+  printf("  bit %d writer / %d reader (%s): %6.2f M op/s, %6.2f M okuma/s, kayip %lu\n",
+         BIT_WRITERS, readers, names[mode], (double)ops / seconds / 1e6,
+         (double)reads / seconds / 1e6, lost);
+  CHECK(ops > 0);
+  return lost;
+}
+
+static void test_bits_no_lost_update(void)
+{
+  CHECK_EQ(bit_stress(BIT_RMW_LOCKED, 2, 0.5), 0u);
+  CHECK_EQ(bit_stress(BIT_ATOMIC, 2, 0.5), 0u);
+  /* karsi ornek (yalniz rapor): IRQ kilidi olmadan ayni word'e RMW bitleri ezer; seq
+   * sayaci da bozulabileceginden reader'siz. Tek cekirdekli host'ta nadiren gorunur. */
+  (void)bit_stress(BIT_RMW_RAW, 0, 0.5);
+}
+
+/* seq_write_begin/end PRIMASK'i geri yuklemeli: IRQ kapali cagiran icin acmamali */
+static void test_primask_restore(void)
+{
+  uint16_t v = 0x1234u;
+  uint32_t bits[APP_REGS_BITS_WORDS(64)];
+  uint8_t packed[2] = {0xA5u, 0x5Au};
+  app_regs_bits_t bs;
+  APP_RegsBitsInit(&bs, bits, 64);
+
+  stub_primask = 0u;
+  CHECK_EQ(APP_RegsWriteHRBlock(BLK_ADDR, &v, 1), 1);
+  CHECK_EQ(stub_primask, 0u);
+  CHECK_EQ(APP_RegsBitsWrite(&bs, 3, packed, 16), 16);
+  CHECK_EQ(stub_primask, 0u);
+
+  stub_primask = 1u; /* cagiran kritik bolgede */
+  CHECK_EQ(APP_RegsWriteHRBlock(BLK_ADDR, &v, 1), 1);
+  CHECK_EQ(stub_primask, 1u);
+  CHECK_EQ(APP_RegsBitsWrite(&bs, 3, packed, 16), 16);
+  CHECK_EQ(stub_primask, 1u);
+  stub_primask = 0u;
+}
+
+/* ------------------ transaction ------------------ */
+
+#define SRC_A 1u
+#define SRC_B 2u
+
+static uint16_t txn_ctrl(uint8_t src, uint16_t cmd)
+{
+  return APP_RegsMapWrite(APP_RegsMainMap(), src, APP_REGS_HR, APP_REGS_TXN_CTRL_ADDR, &cmd, 1);
+}
+
+static uint16_t txn_state(void)
+{
+  uint16_t v = 0xFFFFu;
+  (void)APP_RegsMapRead(APP_RegsMainMap(), APP_REGS_HR, APP_REGS_TXN_CTRL_ADDR, &v, 1);
+  return v;
+}
+
+static uint16_t map_wr1(uint8_t src, uint16_t addr, uint16_t v)
+{
+  return APP_RegsMapWrite(APP_RegsMainMap(), src, APP_REGS_HR, addr, &v, 1);
+}
+
+static void test_txn_owner(void)
+{
+  app_regs_map_t *m = APP_RegsMainMap();
+  uint16_t rd[2];
+  const uint16_t w2[2] = {7, 7};
+
+  CHECK_EQ(map_wr1(SRC_A, 6, 1), 1);
+  CHECK_EQ(map_wr1(SRC_A, 8, 1), 1);
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_BEGIN), 1);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_BEGIN);
+
+  /* owner: staged, gorunmez */
+  CHECK_EQ(map_wr1(SRC_A, 6, 100), 1);
+  CHECK_EQ(APP_RegsReadHR(6), 1);
+
+  /* diger Modbus kaynagi: busy, hicbir yazma yolu shadow'a ulasmaz */
+  CHECK_EQ(map_wr1(SRC_B, 7, 5), APP_REGS_BUSY);
+  CHECK_EQ(APP_RegsMapMaskWrite(m, SRC_B, 7, 0, 5), APP_REGS_BUSY);
+  CHECK_EQ(APP_RegsMapReadWrite(m, SRC_B, 7, w2, 2, 6, rd, 2), APP_REGS_BUSY);
+  CHECK_EQ(txn_ctrl(SRC_B, APP_REGS_TXN_COMMIT), APP_REGS_BUSY);
+  CHECK_EQ(txn_ctrl(SRC_B, APP_REGS_TXN_IDLE), APP_REGS_BUSY);
+  CHECK_EQ(txn_ctrl(SRC_B, APP_REGS_TXN_BEGIN), APP_REGS_BUSY);
+
+  /* yerel yazma: hemen yayinlanir, commit geri almaz */
+  CHECK_EQ(APP_RegsWriteHR(8, 55), 1);
+  CHECK_EQ(APP_RegsReadHR(8), 55);
+
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_COMMIT), 1);
+  CHECK_EQ(APP_RegsReadHR(6), 100);
+  CHECK_EQ(APP_RegsReadHR(8), 55);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_IDLE);
+
+  /* kapandi: B serbest */
+  CHECK_EQ(map_wr1(SRC_B, 7, 5), 1);
+  CHECK_EQ(APP_RegsReadHR(7), 5);
+}
+
+static void test_txn_expire(void)
+{
+  CHECK_EQ(map_wr1(SRC_A, 6, 1), 1);
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_BEGIN), 1);
+  CHECK_EQ(map_wr1(SRC_A, 6, 200), 1);
+
+  /* hic yazma gelmese de periyodik tick iptal eder */
+  stub_tick_ms += APP_REGS_TXN_TIMEOUT_MS / 2u;
+  APP_RegsTick();
+  CHECK_EQ(txn_state(), APP_REGS_TXN_BEGIN);
+  stub_tick_ms += APP_REGS_TXN_TIMEOUT_MS;
+  APP_RegsTick();
+  CHECK_EQ(txn_state(), APP_REGS_TXN_IDLE);
+  CHECK_EQ(APP_RegsReadHR(6), 1);
+  CHECK_EQ(map_wr1(SRC_B, 6, 2), 1);
+
+  /* baglanti kapanisi: sadece kendi transaction'i */
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_BEGIN), 1);
+  APP_RegsTxnRelease(SRC_B);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_BEGIN);
+  APP_RegsTxnRelease(SRC_A);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_IDLE);
+}
+
+/* TXN_CTRL HR0..31 disinda: tum pencereye blok yazma / FC23 transaction'a dokunmaz,
+ * HR31 duz payload. Kontrol word'u yalniz tek basina yazilir. */
+static void test_txn_ctrl_outside_payload(void)
+{
+  app_regs_map_t *m = APP_RegsMainMap();
+  uint16_t v[APP_MODBUS_HR_COUNT], rd[APP_MODBUS_HR_COUNT];
+  for (uint16_t a = 0; a < APP_MODBUS_HR_COUNT; ++a) v[a] = (uint16_t)(a + 1u);
+
+  CHECK_EQ(APP_RegsMapWrite(m, SRC_A, APP_REGS_HR, 0, v, APP_MODBUS_HR_COUNT), APP_MODBUS_HR_COUNT);
+  CHECK_EQ(APP_RegsMapRead(m, APP_REGS_HR, 0, rd, APP_MODBUS_HR_COUNT), APP_MODBUS_HR_COUNT);
+  CHECK_EQ(rd[31], 32u);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_IDLE);
+  CHECK_EQ(APP_RegsWriteHRBlock(0, v, APP_MODBUS_HR_COUNT), APP_MODBUS_HR_COUNT);
+  CHECK_EQ(APP_RegsMapReadWrite(m, SRC_A, 30, v, 2, 0, rd, 4), 1);
+
+  /* transaction icinde HR31 de staged */
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_BEGIN), 1);
+  CHECK_EQ(map_wr1(SRC_A, 31, 777), 1);
+  CHECK_EQ(APP_RegsReadHR(31), 2u); /* FC23 HR30..31 = 1, 2 */
+  CHECK_EQ(txn_ctrl(SRC_A, APP_REGS_TXN_COMMIT), 1);
+  CHECK_EQ(APP_RegsReadHR(31), 777u);
+
+  /* kontrol word'u: cok word'lu / FC22 / FC23 yazma adres hatasi, gecersiz komut reddedilir */
+  const uint16_t two[2] = { APP_REGS_TXN_BEGIN, 0 };
+  CHECK_EQ(APP_RegsMapWrite(m, SRC_A, APP_REGS_HR, APP_REGS_TXN_CTRL_ADDR, two, 2), 0);
+  CHECK_EQ(APP_RegsMapMaskWrite(m, SRC_A, APP_REGS_TXN_CTRL_ADDR, 0, 1), 0);
+  CHECK_EQ(APP_RegsMapReadWrite(m, SRC_A, APP_REGS_TXN_CTRL_ADDR, two, 1, 0, rd, 1), 0);
+  CHECK_EQ(txn_ctrl(SRC_A, 7), 0);
+  CHECK_EQ(txn_state(), APP_REGS_TXN_IDLE);
+}
+
+/* Grup iki ayri yazmayla (HR6..13, HR14..21) kurulur; reader'lar ya eski ya yeni
+ * grubun tamamini gormeli. Transaction olmadan ayni dizi yirtik snapshot uretir. */
+static void *txn_writer_fn(void *arg)
+{
+  const uint8_t use_txn = (uint8_t)(uintptr_t)arg;
+  uint16_t v[BLK_QTY / 2u];
+  for (uint32_t i = 1; !atomic_load(&g_stop); ++i) {
+    for (uint16_t k = 0; k < BLK_QTY / 2u; ++k) v[k] = (uint16_t)i;
+    if (use_txn) (void)txn_ctrl(SRC_A, APP_REGS_TXN_BEGIN);
+    (void)APP_RegsMapWrite(APP_RegsMainMap(), SRC_A, APP_REGS_HR, BLK_ADDR, v, BLK_QTY / 2u);
+    (void)APP_RegsMapWrite(APP_RegsMainMap(), SRC_A, APP_REGS_HR, BLK_ADDR + BLK_QTY / 2u, v, BLK_QTY / 2u);
+    if (use_txn) (void)txn_ctrl(SRC_A, APP_REGS_TXN_COMMIT);
+    atomic_fetch_add(&g_writes, 1);
+  }
+  return NULL;
+}
+
+static unsigned long txn_stress(uint8_t use_txn, double seconds)
+{
+  pthread_t wt, rt[4];
+  reader_t rs[4];
+  memset(rs, 0, sizeof(rs));
+  atomic_store(&g_stop, 0);
+  atomic_store(&g_torn, 0);
+  atomic_store(&g_writes, 0);
+
+  pthread_create(&wt, NULL, txn_writer_fn, (void *)(uintptr_t)use_txn);
+  for (int i = 0; i < 4; ++i) pthread_create(&rt[i], NULL, reader_fn, &rs[i]);
+
+  const double t0 = test_now_s();
+  while (test_now_s() - t0 < seconds) { }
+  atomic_store(&g_stop, 1);
+  pthread_join(wt, NULL);
+  for (int i = 0; i < 4; ++i) pthread_join(rt[i], NULL);
+
+  unsigned long reads = 0;
+  for (int i = 0; i < 4; ++i) reads += rs[i].reads;
+  printf("  %s: %6.2f M grup/s, %6.2f M snapshot/s, yirtik %lu\n",
+         use_txn ? "transaction" : "txn yok    ", (double)atomic_load(&g_writes) / seconds / 1e6,
+         (double)reads / seconds / 1e6, (unsigned long)atomic_load(&g_torn));
+  CHECK(reads > 0);
+  return (unsigned long)atomic_load(&g_torn);
+}
+
+static void test_txn_no_torn(void)
+{
+  CHECK_EQ(txn_stress(1, 0.5), 0u);
+  CHECK(txn_stress(0, 0.5) > 0u); /* karsi ornek: test yirtilmayi gorebiliyor */
+}
+
+static void bench_uncontended(void)
+{
+  uint16_t out[BLK_QTY];
+  const int n = 2000000;
+  app_regs_bank_t *b = APP_RegsMainBank();
+
+  double t0 = test_now_s();
+  for (int i = 0; i < n; ++i) (void)APP_RegsReadHRBlock(BLK_ADDR, out, BLK_QTY);
+  const double lf = (test_now_s() - t0) * 1e9 / n;
+
+  t0 = test_now_s();
+  for (int i = 0; i < n; ++i) {
+    osMutexAcquire(b->mutex, osWaitForever);
+    memcpy(out, (const uint16_t *)&b->hr[BLK_ADDR], sizeof(out));
+    osMutexRelease(b->mutex);
+  }
+  const double mx = (test_now_s() - t0) * 1e9 / n;
+  printf("  16 word okuma: lock-free %.1f ns, mutex %.1f ns\n", lf, mx);
+}
+
+int main(void)
+{
+  APP_RegsInit();
+
+  RUN(test_primask_restore);
+  RUN(test_txn_owner);
+  RUN(test_txn_expire);
+  RUN(test_txn_ctrl_outside_payload);
+  RUN(test_txn_no_torn);
+  RUN(test_bits_no_lost_update);
+  RUN(bench_uncontended);
+  printf("stress\n");
+  stress(1, 1, 0, 0.5);
+  stress(1, 4, 0, 0.5);
+  stress(2, 4, 0, 0.5);
+  stress(1, 4, 1, 0.5);
+  stress(2, 4, 1, 0.5);
+  return test_summary();
+}
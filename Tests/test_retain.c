@@ -0,0 +1,204 @@
+/*
+ * Host test: retain flash log (Core/Src/app_retain.c) flash simulasyonu uzerinde.
+ * Boot sonrasi geri yukleme, program/erase hatasinda pending'in korunmasi, compaction
+ * ortasinda guc kesintisi ve write amplification / sektor omru benchmark'i.
+ * app_retain.c dogrudan include edilir (fl_flush / s_fl_* static).
+ */
+#include "../Core/Src/app_retain.c"
+
+#include "flash_sim.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+#define HR_N        APP_MODBUS_HR_COUNT
+#define ENDURANCE   10000u /* F407 flash: sektor basina garanti silme sayisi */
+
+static uint16_t nret(void)
+{
+  uint16_t n = 0;
+  for (uint16_t a = 0; a < HR_N; ++a) n = (uint16_t)(n + is_ret(a));
+  return n;
+}
+
+/* keep_bkp = 0: VBAT yok, sadece flash kopyasi */
+static void reboot(int keep_bkp)
+{
+  if (!keep_bkp) memset(stub_bkpsram, 0, sizeof(stub_bkpsram));
+  APP_RegsInit();
+  APP_RetainInit();
+}
+
+static uint8_t flush(void)
+{
+  uint16_t hr[HR_N];
+  (void)APP_RegsReadHRBlock(0, hr, HR_N);
+  return fl_flush(hr);
+}
+
+static void set_date(uint16_t y, uint16_t m, uint16_t d)
+{
+  (void)APP_RegsWriteHR(APP_HR_YEAR, y);
+  (void)APP_RegsWriteHR(APP_HR_MONTH, m);
+  (void)APP_RegsWriteHR(APP_HR_DAY, d);
+}
+
+static void check_date(uint16_t y, uint16_t m, uint16_t d)
+{
+  CHECK_EQ(APP_RegsReadHR(APP_HR_YEAR), y);
+  CHECK_EQ(APP_RegsReadHR(APP_HR_MONTH), m);
+  CHECK_EQ(APP_RegsReadHR(APP_HR_DAY), d);
+}
+
+static void test_roundtrip(void)
+{
+  flash_sim_reset();
+  reboot(0);
+  CHECK_EQ(s_stats.source, APP_RETAIN_SRC_DEFAULT);
+
+  set_date(2026, 10, 17);
+  CHECK_EQ(flush(), 1);
+  CHECK_EQ(g_flash_sim.erases, 1u); /* ilk flush: bos flash -> compaction */
+
+  reboot(0);
+  CHECK_EQ(s_stats.source, APP_RETAIN_SRC_FLASH);
+  check_date(2026, 10, 17);
+
+  /* degisiklik: sadece degisen register record alir */
+  const uint32_t p0 = g_flash_sim.programs;
+  (void)APP_RegsWriteHR(APP_HR_DAY, 18);
+  CHECK_EQ(flush(), 1);
+  CHECK_EQ(g_flash_sim.programs - p0, 1u);
+  CHECK_EQ(flush(), 1); /* degisiklik yok: program yok */
+  CHECK_EQ(g_flash_sim.programs - p0, 1u);
+
+  reboot(0);
+  check_date(2026, 10, 18);
+  CHECK_EQ(g_flash_sim.bad_programs, 0u);
+}
+
+/* Program hatasi: fl_flush 0 doner (task pending tutar), tekrar deneme temiz sektore */
+static void test_program_fail_keeps_pending(void)
+{
+  flash_sim_reset();
+  reboot(0);
+  set_date(2026, 2, 1);
+  CHECK_EQ(flush(), 1);
+  const uint8_t  sec = s_fl_active;
+  const uint32_t erases = g_flash_sim.erases;
+
+  (void)APP_RegsWriteHR(APP_HR_DAY, 9);
+  g_flash_sim.fail_in = 1;
+  g_flash_sim.power_cut = 1; /* yarim programlanmis word */
+  CHECK_EQ(flush(), 0);
+  g_flash_sim.power_cut = 0;
+  CHECK_EQ(s_stats.errors, 1u);
+  CHECK(fl_stale(APP_HR_DAY, 9)); /* hala yazilmamis sayilir */
+
+  /* reset olmadan tekrar deneme: yarim word'un uzerine degil, diger sektore compaction */
+  CHECK_EQ(flush(), 1);
+  CHECK_EQ(g_flash_sim.erases, erases + 1u);
+  CHECK(s_fl_active != sec);
+  reboot(0);
+  check_date(2026, 2, 9);
+
+  /* tekrar denemeden once reset: yarim word gecersiz, eski deger geri gelir */
+  (void)APP_RegsWriteHR(APP_HR_DAY, 10);
+  g_flash_sim.fail_in = 1;
+  g_flash_sim.power_cut = 1;
+  CHECK_EQ(flush(), 0);
+  g_flash_sim.power_cut = 0;
+  reboot(0);
+  check_date(2026, 2, 9);
+  CHECK_EQ(g_flash_sim.bad_programs, 0u);
+}
+
+/* Compaction ortasinda guc kesintisi: header en son yazildigi icin, generation word'u
+ * tamamlanana kadar eski sektor gecerli kalir. Generation'in kendisi yarim kalirsa
+ * (silinmis degil, eskisinden buyuk) yeni sektor zaten tam: iki durumda da tutarli. */
+static void test_compaction_power_cut(void)
+{
+  flash_sim_reset();
+  reboot(0);
+  set_date(2025, 5, 5);
+  CHECK_EQ(flush(), 1);
+
+  const uint16_t n = nret();
+  for (uint32_t k = 1; k <= 1u + n + 2u; ++k) {
+    /* k. islemde kesinti: 1 = erase, 2..n+1 = record, n+2 = layout, n+3 = generation */
+    s_fl_wp = RET_FL_WORDS; /* sektor dolu: sonraki flush compaction */
+    set_date(2026, 6, (uint16_t)k);
+    g_flash_sim.fail_in = (int32_t)k;
+    g_flash_sim.power_cut = 1;
+    CHECK_EQ(flush(), 0);
+    g_flash_sim.power_cut = 0;
+
+    reboot(0);
+    CHECK_EQ(s_stats.source, APP_RETAIN_SRC_FLASH);
+    if (k < 1u + n + 2u || APP_RegsReadHR(APP_HR_YEAR) == 2025u) {
+      check_date(2025, 5, 5);
+    } else {
+      check_date(2026, 6, (uint16_t)k);
+    }
+  }
+
+  s_fl_wp = RET_FL_WORDS;
+  set_date(2026, 7, 7);
+  CHECK_EQ(flush(), 1);
+  reboot(0);
+  check_date(2026, 7, 7);
+}
+
+/* Write amplification: her flush'ta `changed` RET register degisir */
+static void bench_wa(uint16_t changed, uint32_t flushes)
+{
+  flash_sim_reset();
+  reboot(0);
+  stub_dwt.CYCCNT = 0;
+
+  uint16_t ret_addr[HR_N];
+  uint16_t k = 0;
+  for (uint16_t a = 0; a < HR_N; ++a) {
+    if (is_ret(a)) ret_addr[k++] = a;
+  }
+  if (changed > k) changed = k;
+
+  uint32_t updates = 0;
+  for (uint32_t f = 1; f <= flushes; ++f) {
+    for (uint16_t c = 0; c < changed; ++c) {
+      (void)APP_RegsWriteHR(ret_addr[(f + c) % k], (uint16_t)f);
+      updates++;
+    }
+    (void)flush();
+  }
+
+  const double wa     = (double)g_flash_sim.programs * 4.0 / ((double)updates * 2.0);
+  const double per_er = (double)flushes / (g_flash_sim.erases ? g_flash_sim.erases : 1u);
+  /* her flush APP_RETAIN_FLASH_DELAY_MS'de bir (en kotu), iki sektor sirayla silinir */
+  const double er_day = 86400.0 * 1000.0 / APP_RETAIN_FLASH_DELAY_MS / per_er / 2.0;
+  printf("  %u/%u RET degisiyor: %u flush, %u word, %u erase -> WA %.2f, %.0f flush/erase, "
+         "sektor omru %.1f yil (%u cycle), erase %u us\n",
+         changed, k, flushes, g_flash_sim.programs, g_flash_sim.erases, wa, per_er,
+         ENDURANCE / er_day / 365.0, ENDURANCE, s_stats.erase_max_us);
+
+  CHECK_EQ(g_flash_sim.bad_programs, 0u);
+  uint16_t want[HR_N];
+  (void)APP_RegsReadHRBlock(0, want, HR_N);
+  reboot(0);
+  for (uint16_t c = 0; c < k; ++c) CHECK_EQ(APP_RegsReadHR(ret_addr[c]), want[ret_addr[c]]);
+}
+
+static void bench_write_amplification(void)
+{
+  bench_wa(1, 200000);
+  bench_wa(nret(), 200000);
+}
+
+int main(void)
+{
+  RUN(test_roundtrip);
+  RUN(test_program_fail_keeps_pending);
+  RUN(test_compaction_power_cut);
+  RUN(bench_write_amplification);
+  return test_summary();
+}
@@ -0,0 +1,38 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+/* Host testleri icin minimal assert/rapor yardimcilari (framework yok) */
+
+#include <stdio.h>
+#include <time.h>
+
+static int g_test_fail = 0;
+static int g_test_checks = 0;
+
+#define CHECK(c) do { \
+    g_test_checks++; \
+    if (!(c)) { g_test_fail++; printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); } \
+  } while (0)
+
+#define CHECK_EQ(a, b) do { \
+    g_test_checks++; \
+    const unsigned long long a_ = (unsigned long long)(a), b_ = (unsigned long long)(b); \
+    if (a_ != b_) { g_test_fail++; printf("  FAIL %s:%d: %s == %llu, beklenen %llu\n", __FILE__, __LINE__, #a, a_, b_); } \
+  } while (0)
+
+#define RUN(fn) do { printf("%s\n", #fn); fn(); } while (0)
+
+static inline double test_now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline int test_summary(void)
+{
+  printf("%s: %d check, %d hata\n", g_test_fail ? "FAIL" : "OK", g_test_checks, g_test_fail);
+  return g_test_fail ? 1 : 0;
+}
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+Modbus TCP coklu istemci yuk testi (cihaza karsi, PC'den).
+
+Kullanim: mbbench.py HOST [--clients 4] [--stalled 1] [--seconds 10]
+                          [--unit 10] [--addr 0] [--qty 16] [--depth 1] [--udp]
+
+--clients istemcinin her biri kendi baglantisinda FC03 (addr, qty) okur; ayni anda
+--depth istek havada tutulur (pipelining). --stalled istemci istek gonderip cevaplari
+hic okumaz: send window'u dolar. Server onlari beklerken digerleri yavaslamamali
+(session basina bekleyen TX, nonblocking write) ve APP_MODBUS_TX_STALL_MS sonra
+stalled baglantilar kapatilmali.
+
+Cikis: istemci basina istek/s, toplam istek/s, hata/timeout sayisi ve istek->cevap
+gecikmesi (p50/p90/p99/max, ms). --diag ile sonunda diagnostics blogundan (HR 0x1000)
+FC03/FC04 cevap cache'inin hit/miss sayisi ve istek basina ortalama DWT cycle'i okunur. Engine karsilastirmasi (NETCONN / RAW) icin ayni
+parametrelerle iki firmware'e karsi calistirilir; --depth 1 saf round-trip olcer.
+
+--udp: TCP turundan sonra ayni yuk (istemci sayisi, FC03 addr/qty, depth, sure)
+APP_MODBUS_UDP_PORT'a (--udp-port, varsayilan 502) datagram olarak tekrarlanir ve iki
+transport'un req/s'i yan yana basilir. UDP'de --timeout icinde cevap gelmeyen istekler
+"kayip" sayilip yeniden gonderilir; stalled istemciler yalniz TCP turunda calisir.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+
+def build_req(tid, unit, addr, qty):
+    return struct.pack(">HHHBBHH", tid & 0xFFFF, 0, 6, unit, 3, addr, qty)
+
+
+def recv_exact(sock, n):
+    buf = b""
+    while len(buf) < n:
+        chunk = sock.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("closed")
+        buf += chunk
+    return buf
+
+
+def recv_adu(sock):
+    hdr = recv_exact(sock, 7)
+    _, _, length, _ = struct.unpack(">HHHB", hdr)
+    return hdr + recv_exact(sock, length - 1)
+
+
+class Client(threading.Thread):
+    def __init__(self, args, idx, stop, on_reply=None):
+        super().__init__(daemon=True)
+        self.args = args
+        self.idx = idx
+        self.stop = stop
+        self.on_reply = on_reply
+        self.count = 0
+        self.errors = 0
+        self.exc = 0
+
+    def run(self):
+        a = self.args
+        tid = 0
+        while not self.stop.is_set():
+            try:
+                with socket.create_connection((a.host, a.port), timeout=a.timeout) as s:
+                    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                    sent = {}
+                    for _ in range(a.depth):
+                        tid += 1
+                        sent[tid & 0xFFFF] = time.perf_counter()
+                        s.sendall(build_req(tid, a.unit, a.addr, a.qty))
+                    while not self.stop.is_set():
+                        rsp = recv_adu(s)
+                        rtid = struct.unpack_from(">H", rsp, 0)[0]
+                        t0 = sent.pop(rtid, None)
+                        if rsp[7] & 0x80:
+                            self.exc += 1
+                        self.count += 1
+                        if self.on_reply and t0 is not None:
+                            self.on_reply(time.perf_counter() - t0)
+                        tid += 1
+                        sent[tid & 0xFFFF] = time.perf_counter()
+                        s.sendall(build_req(tid, a.unit, a.addr, a.qty))
+            except (OSError, ConnectionError):
+                self.errors += 1
+                time.sleep(0.2)
+
+
+class UdpClient(threading.Thread):
+    """Client'in UDP karsiligi: her datagram tek MBAP ADU, --depth istek havada."""
+
+    def __init__(self, args, idx, stop, on_reply=None):
+        super().__init__(daemon=True)
+        self.args = args
+        self.idx = idx
+        self.stop = stop
+        self.on_reply = on_reply
+        self.count = 0
+        self.errors = 0   # cevapsiz kalip yeniden gonderilen istek
+        self.exc = 0
+
+    def run(self):
+        a = self.args
+        tid = 0
+        with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+            s.connect((a.host, a.udp_port))
+            s.settimeout(a.timeout)
+            sent = {}
+
+            def send_one():
+                nonlocal tid
+                tid += 1
+                sent[tid & 0xFFFF] = time.perf_counter()
+                s.send(build_req(tid, a.unit, a.addr, a.qty))
+
+            for _ in range(a.depth):
+                send_one()
+            while not self.stop.is_set():
+                try:
+                    rsp = s.recv(512)
+                except socket.timeout:
+                    self.errors += len(sent)
+                    sent.clear()
+                    for _ in range(a.depth):
+                        send_one()
+                    continue
+                except OSError:
+                    self.errors += 1
+                    time.sleep(0.2)
+                    continue
+                if len(rsp) < 9:
+                    continue
+                t0 = sent.pop(struct.unpack_from(">H", rsp, 0)[0], None)
+                if t0 is None:
+                    continue  # gec gelen (zaten kayip sayilmis) cevap
+                if rsp[7] & 0x80:
+                    self.exc += 1
+                self.count += 1
+                if self.on_reply:
+                    self.on_reply(time.perf_counter() - t0)
+                send_one()
+
+
+class Stalled(threading.Thread):
+    """Istek yagdirir, cevap okumaz; server kapatinca sayar."""
+
+    def __init__(self, args, stop):
+        super().__init__(daemon=True)
+        self.args = args
+        self.stop = stop
+        self.closed_after = None
+
+    def run(self):
+        a = self.args
+        t0 = time.monotonic()
+        try:
+            with socket.create_connection((a.host, a.port), timeout=a.timeout) as s:
+                s.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024)
+                s.settimeout(0.5)
+                tid = 0
+                while not self.stop.is_set():
+                    tid += 1
+                    try:
+                        s.send(build_req(tid, a.unit, a.addr, 125))
+                    except socket.timeout:
+                        continue
+        except OSError:
+            self.closed_after = time.monotonic() - t0
+
+
+def read_diag(a):
+    """Diagnostics header: hit, miss, hit basina cycle, miss basina cycle (32-bit, hi once)."""
+    with socket.create_connection((a.host, a.port), timeout=a.timeout) as s:
+        s.sendall(build_req(1, a.unit, 0x1000, 12))
+        rsp = recv_adu(s)
+    if rsp[7] & 0x80:
+        raise ConnectionError("diag exception %d" % rsp[8])
+    w = struct.unpack(">12H", rsp[9:9 + 24])
+    u32 = lambda i: (w[i] << 16) | w[i + 1]
+    return w[0], u32(4), u32(6), u32(8), u32(10)
+
+
+def percentile(sorted_vals, q):
+    if not sorted_vals:
+        return float("nan")
+    k = min(len(sorted_vals) - 1, max(0, int(round(q * (len(sorted_vals) - 1)))))
+    return sorted_vals[k]
+
+
+def run_load(a, cls, name, err_name, n_stalled):
+    """a.clients adet cls istemcisini a.seconds calistirip ozetini basar; (toplam, sure)."""
+    lat = []
+    lat_lock = threading.Lock()
+
+    def on_reply(dt):
+        with lat_lock:
+            lat.append(dt)
+
+    stop = threading.Event()
+    clients = [cls(a, i, stop, on_reply) for i in range(a.clients)]
+    t0 = time.monotonic()
+    for c in clients:
+        c.start()
+    time.sleep(a.seconds)
+    stop.set()
+    dt = time.monotonic() - t0
+    for c in clients:
+        c.join(a.timeout + 1)
+
+    total = 0
+    print("[%s]" % name)
+    for c in clients:
+        total += c.count
+        print("client %d: %8.1f req/s  (exc %d, %s %d)" % (c.idx, c.count / dt, c.exc, err_name, c.errors))
+    print("toplam  : %8.1f req/s, %d istemci, %d stalled" % (total / dt, a.clients, n_stalled))
+    with lat_lock:
+        v = sorted(lat)
+    print("gecikme : p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms  (%d ornek)" % (
+        percentile(v, 0.50) * 1e3, percentile(v, 0.90) * 1e3, percentile(v, 0.99) * 1e3,
+        (v[-1] if v else float("nan")) * 1e3, len(v)))
+    return total, dt
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=502)
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--stalled", type=int, default=0)
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--unit", type=int, default=10)
+    ap.add_argument("--addr", type=int, default=0)
+    ap.add_argument("--qty", type=int, default=16)
+    ap.add_argument("--depth", type=int, default=1)
+    ap.add_argument("--timeout", type=float, default=3.0)
+    ap.add_argument("--diag", action="store_true")
+    ap.add_argument("--udp", action="store_true")
+    ap.add_argument("--udp-port", type=int, default=502)
+    a = ap.parse_args()
+
+    stop = threading.Event()
+    stalled = [Stalled(a, stop) for _ in range(a.stalled)]
+    for t in stalled:
+        t.start()
+    time.sleep(0.5 if stalled else 0)  # stalled istemciler once window'u doldursun
+
+    tcp_total, tcp_dt = run_load(a, Client, "tcp", "conn err", a.stalled)
+    stop.set()
+    udp_total = None
+    if a.udp:
+        udp_total, udp_dt = run_load(a, UdpClient, "udp", "kayip", 0)
+    if a.diag:
+        ver, hits, misses, hit_cyc, miss_cyc = read_diag(a)
+        print("cache   : hit %d (%d cyc), miss %d (%d cyc)  [diag v%d]" % (hits, hit_cyc, misses, miss_cyc, ver))
+    for i, t in enumerate(stalled):
+        t.join(1)
+        state = "kapatildi %.1f s" % t.closed_after if t.closed_after is not None else "acik"
+        print("stalled %d: %s" % (i, state))
+    if udp_total is not None:
+        tcp_rate, udp_rate = tcp_total / tcp_dt, udp_total / udp_dt
+        print("tcp/udp : %8.1f / %8.1f req/s  (udp/tcp %.2fx)" % (
+            tcp_rate, udp_rate, udp_rate / tcp_rate if tcp_rate else float("nan")))
+        return 0 if tcp_total and udp_total else 1
+    return 0 if tcp_total else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
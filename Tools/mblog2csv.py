@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Binary Modbus log (APP_LOG_FORMAT_BIN, Core/Src/app_log.c) -> CSV.
+
+Kullanim: mblog2csv.py LOGS/20260131.BIN [cikis.csv]
+          mblog2csv.py LOGS/20260131.SMP [cikis_oneki]
+
+SMP (sampler) dosyasinda her kanal ayri CSV'ye yazilir: <onek>_ch<N>.csv
+(onek verilmezse giris dosyasinin adi), kolonlar tick_ms,hrN... (ham u16).
+
+Dosya [header, record...] segmentlerinden olusur. Cikis, cihazin CSV moduyla ayni
+kolonlari verir (tick_ms,minutes,seconds,hrN...); 32/64-bit tipler header'daki
+word order ile cozulur, devam word'lerinin kolonlari bos kalir. Tip/kolon sayisi
+dosya boyunca sabit oldugu icin (segment header'i degismedikce) Parquet vb. araclara
+dogrudan yuklenebilir. CRC'si tutmayan record'lar atlanir ve stderr'e yazilir.
+"""
+
+import csv
+import struct
+import sys
+
+MAGIC = b"MBL1"
+SMP_MAGIC = b"MBS1"
+
+# APP_REGS_T_* : (word sayisi, struct format, signed)
+TYPES = {
+    0: (1, "H"), 1: (1, "h"),
+    2: (2, "I"), 3: (2, "i"), 4: (2, "f"),
+    5: (4, "Q"), 6: (4, "q"), 7: (4, "d"),
+}
+
+WO_BE, WO_WS, WO_LE = 0, 1, 2
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def words_to_int(words, order):
+    if order == WO_BE:
+        seq = words
+    elif order == WO_WS:
+        seq = list(reversed(words))
+    else:
+        seq = [((w & 0xFF) << 8) | (w >> 8) for w in reversed(words)]
+    v = 0
+    for w in seq:
+        v = (v << 16) | w
+    return v
+
+
+def decode(words, types, order):
+    out = []
+    i = 0
+    while i < len(words):
+        nw, fmt = TYPES.get(types[i], (1, "H"))
+        if nw == 1 or i + nw > len(words):
+            out.append(struct.unpack("<" + fmt, struct.pack("<H", words[i]))[0] if nw == 1 else words[i])
+            i += 1
+            continue
+        raw = words_to_int(words[i:i + nw], order)
+        size = {2: "I", 4: "Q"}[nw]
+        val = struct.unpack("<" + fmt, struct.pack("<" + size, raw))[0]
+        out.append(round(val, 3) if fmt in "fd" else val)
+        out.extend([""] * (nw - 1))
+        i += nw
+    return out
+
+
+def parse_header(buf, pos):
+    if buf[pos:pos + 4] != MAGIC or pos + 12 > len(buf):
+        return None
+    hlen, rlen, count = struct.unpack_from("<HHH", buf, pos + 4)
+    if pos + hlen > len(buf) or hlen < 12 + 3 * count + 2:
+        return None
+    if crc16(buf[pos:pos + hlen - 2]) != struct.unpack_from("<H", buf, pos + hlen - 2)[0]:
+        return None
+    order = buf[pos + 10]
+    addrs = list(struct.unpack_from("<%dH" % count, buf, pos + 12))
+    types = list(buf[pos + 12 + 2 * count:pos + 12 + 3 * count])
+    return {"len": hlen, "rec": rlen, "count": count, "order": order, "addrs": addrs, "types": types}
+
+
+def convert(path, out):
+    buf = open(path, "rb").read()
+    w = csv.writer(out, lineterminator="\n")
+    hdr = None
+    cols = None
+    pos = 0
+    bad = 0
+    while pos < len(buf):
+        h = parse_header(buf, pos)
+        if h is not None:
+            hdr = h
+            names = ["tick_ms", "minutes", "seconds"] + ["hr%d" % a for a in h["addrs"]]
+            if names != cols:
+                w.writerow(names)
+                cols = names
+            pos += h["len"]
+            continue
+        if hdr is None or pos + hdr["rec"] > len(buf):
+            break
+        rec = buf[pos:pos + hdr["rec"]]
+        pos += hdr["rec"]
+        if crc16(rec[:-2]) != struct.unpack_from("<H", rec, len(rec) - 2)[0]:
+            bad += 1
+            continue
+        tick, mm, ss = struct.unpack_from("<IHH", rec, 0)
+        words = list(struct.unpack_from("<%dH" % hdr["count"], rec, 8))
+        w.writerow([tick, mm, ss] + decode(words, hdr["types"], hdr["order"]))
+    if bad:
+        sys.stderr.write("%s: %d record CRC hatasi\n" % (path, bad))
+
+
+def parse_smp_header(buf, pos):
+    if buf[pos:pos + 4] != SMP_MAGIC or pos + 10 > len(buf):
+        return None
+    hlen, count, order = struct.unpack_from("<HBB", buf, pos + 4)
+    if pos + hlen > len(buf) or hlen < 10:
+        return None
+    if crc16(buf[pos:pos + hlen - 2]) != struct.unpack_from("<H", buf, pos + hlen - 2)[0]:
+        return None
+    chans = []
+    p = pos + 8
+    for _ in range(count):
+        n, flags, period = struct.unpack_from("<BBH", buf, p)
+        addrs = list(struct.unpack_from("<%dH" % n, buf, p + 4))
+        chans.append({"n": n, "deadband": bool(flags & 1), "period_ms": period, "addrs": addrs})
+        p += 4 + 2 * n
+    return {"len": hlen, "order": order, "chans": chans}
+
+
+def convert_smp(path, prefix):
+    buf = open(path, "rb").read()
+    files = {}
+    hdr = None
+    pos = 0
+    bad = 0
+    try:
+        while pos < len(buf):
+            h = parse_smp_header(buf, pos)
+            if h is not None:
+                hdr = h
+                for k, c in enumerate(h["chans"]):
+                    names = ["tick_ms"] + ["hr%d" % a for a in c["addrs"]]
+                    if k not in files:
+                        f = open("%s_ch%d.csv" % (prefix, k), "w", newline="")
+                        files[k] = [f, csv.writer(f, lineterminator="\n"), None]
+                    if files[k][2] != names:
+                        files[k][1].writerow(names)
+                        files[k][2] = names
+                pos += h["len"]
+                continue
+            if hdr is None or pos + 2 > len(buf):
+                break
+            ch, n = buf[pos], buf[pos + 1]
+            rlen = 6 + 2 * n + 2
+            if ch >= len(hdr["chans"]) or n != hdr["chans"][ch]["n"] or pos + rlen > len(buf):
+                break
+            rec = buf[pos:pos + rlen]
+            pos += rlen
+            if crc16(rec[:-2]) != struct.unpack_from("<H", rec, rlen - 2)[0]:
+                bad += 1
+                continue
+            tick = struct.unpack_from("<I", rec, 2)[0]
+            files[ch][1].writerow([tick] + list(struct.unpack_from("<%dH" % n, rec, 6)))
+    finally:
+        for f in files.values():
+            f[0].close()
+    if bad:
+        sys.stderr.write("%s: %d record CRC hatasi\n" % (path, bad))
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.stderr.write(__doc__)
+        return 2
+    with open(sys.argv[1], "rb") as f:
+        smp = f.read(4) == SMP_MAGIC
+    if smp:
+        prefix = sys.argv[2] if len(sys.argv) > 2 else sys.argv[1].rsplit(".", 1)[0]
+        convert_smp(sys.argv[1], prefix)
+        return 0
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], "w", newline="") as f:
+            convert(sys.argv[1], f)
+    else:
+        convert(sys.argv[1], sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())